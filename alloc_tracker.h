@@ -0,0 +1,330 @@
+// Allocation tracker with call-site attribution
+// Opt-in: build with -DLEVELFORGE_ALLOC_TRACKING (./build.sh honours
+// ALLOC_TRACKING=1). Replaces global operator new/delete and can hook Jolt's and
+// Box2D's allocators. Every allocation updates cheap global counters; one in
+// kAllocSampleInterval also captures a call stack, which is aggregated into a
+// per-call-site histogram of count, bytes and lifetime. Sampled blocks are
+// marked in a lock-free counting filter, so freeing an unsampled block (nearly
+// all of them) never touches the table lock.
+//
+// Without the define this header only provides no-op stubs. It replaces the
+// global allocation functions, so include it from exactly one translation unit.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct AllocStats {
+    uint64_t allocCount;
+    uint64_t freeCount;
+    uint64_t bytesAllocated;
+    int64_t liveBytes;
+};
+
+#ifdef LEVELFORGE_ALLOC_TRACKING
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <execinfo.h>
+#include <malloc.h>
+#include <mutex>
+#include <new>
+
+// The hooks stay out of line so every sampled stack has the same number of
+// tracker frames on top, and so the compiler never sees new paired with free
+#define ALLOC_TRACKER_NOINLINE __attribute__((noinline))
+
+constexpr int kAllocSampleInterval = 64;
+constexpr int kAllocStackDepth = 12;
+constexpr int kAllocSkipFrames = 4; // Sample, OnAlloc, Allocate and operator new / the Jolt hook
+constexpr size_t kAllocMaxSites = 4096;
+constexpr size_t kAllocMaxLive = 1 << 16;
+constexpr size_t kAllocFilterSlots = 1 << 18; // Several per live entry, so false positives are rare
+
+struct AllocSite {
+    uint64_t hash;
+    const char* category;
+    int depth;
+    void* frames[kAllocStackDepth];
+    uint64_t count;
+    uint64_t bytes;
+    uint64_t frees;
+    uint64_t lifetimeNs;
+};
+
+struct AllocLiveEntry {
+    void* ptr; // nullptr = empty, kAllocTombstone = deleted
+    uint32_t site;
+    uint64_t startNs;
+};
+
+// Everything here is constant-initialized: operator new can run before any
+// dynamic initializer does
+namespace alloc_tracker {
+    inline std::atomic<uint64_t> gAllocCount { 0 };
+    inline std::atomic<uint64_t> gFreeCount { 0 };
+    inline std::atomic<uint64_t> gBytesAllocated { 0 };
+    inline std::atomic<int64_t> gLiveBytes { 0 };
+
+    inline std::mutex gTableMutex;
+    inline AllocSite* gSites = nullptr;
+    inline size_t gSiteCount = 0;
+    inline AllocLiveEntry* gLive = nullptr;
+    inline std::atomic<uint32_t> gSampledFilter[kAllocFilterSlots]; // Live sampled blocks per pointer hash
+
+    inline thread_local bool tInHook = false;
+    inline thread_local int tUntilSample = kAllocSampleInterval;
+
+    inline void* const kAllocTombstone = (void*)1;
+
+    inline uint64_t NowNs() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
+    inline size_t HashPtr(void* ptr) {
+        uint64_t x = (uint64_t)(uintptr_t)ptr;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        return (size_t)x;
+    }
+
+    // Tables come straight from calloc so they never recurse into the hooks
+    inline bool EnsureTables() {
+        if (gSites != nullptr) return true;
+        gSites = (AllocSite*)calloc(kAllocMaxSites, sizeof(AllocSite));
+        gLive = (AllocLiveEntry*)calloc(kAllocMaxLive, sizeof(AllocLiveEntry));
+        return gSites != nullptr && gLive != nullptr;
+    }
+
+    inline uint32_t FindOrAddSite(uint64_t hash, const char* category, void** frames, int depth) {
+        size_t slot = hash % kAllocMaxSites;
+        for (size_t probe = 0; probe < kAllocMaxSites; probe++) {
+            AllocSite& site = gSites[(slot + probe) % kAllocMaxSites];
+            if (site.hash == 0) {
+                if (gSiteCount * 4 >= kAllocMaxSites * 3) return UINT32_MAX; // Keep probes short
+                site.hash = hash;
+                site.category = category;
+                site.depth = depth;
+                memcpy(site.frames, frames, sizeof(void*) * depth);
+                gSiteCount++;
+                return (uint32_t)((slot + probe) % kAllocMaxSites);
+            }
+            if (site.hash == hash && site.category == category) {
+                return (uint32_t)((slot + probe) % kAllocMaxSites);
+            }
+        }
+        return UINT32_MAX;
+    }
+
+    ALLOC_TRACKER_NOINLINE inline void Sample(void* ptr, size_t size, const char* category) {
+        void* stack[kAllocStackDepth + kAllocSkipFrames];
+        int depth = backtrace(stack, kAllocStackDepth + kAllocSkipFrames);
+        int skip = std::min(depth, kAllocSkipFrames);
+        void** frames = stack + skip;
+        depth -= skip;
+
+        uint64_t hash = 1469598103934665603ull;
+        for (int i = 0; i < depth; i++) {
+            hash = (hash ^ (uint64_t)(uintptr_t)frames[i]) * 1099511628211ull;
+        }
+        if (hash == 0) hash = 1;
+
+        std::lock_guard<std::mutex> lock(gTableMutex);
+        if (!EnsureTables()) return;
+
+        uint32_t siteIndex = FindOrAddSite(hash, category, frames, depth);
+        if (siteIndex == UINT32_MAX) return;
+        gSites[siteIndex].count++;
+        gSites[siteIndex].bytes += size;
+
+        size_t slot = HashPtr(ptr) % kAllocMaxLive;
+        for (size_t probe = 0; probe < 64; probe++) {
+            AllocLiveEntry& entry = gLive[(slot + probe) % kAllocMaxLive];
+            if (entry.ptr == nullptr || entry.ptr == kAllocTombstone) {
+                entry = { ptr, siteIndex, NowNs() };
+                gSampledFilter[HashPtr(ptr) % kAllocFilterSlots].fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    inline void Unsample(void* ptr) {
+        std::lock_guard<std::mutex> lock(gTableMutex);
+        if (gLive == nullptr) return;
+
+        size_t slot = HashPtr(ptr) % kAllocMaxLive;
+        for (size_t probe = 0; probe < 64; probe++) {
+            AllocLiveEntry& entry = gLive[(slot + probe) % kAllocMaxLive];
+            if (entry.ptr == nullptr) return;
+            if (entry.ptr == ptr) {
+                AllocSite& site = gSites[entry.site];
+                site.frees++;
+                site.lifetimeNs += NowNs() - entry.startNs;
+                entry.ptr = kAllocTombstone;
+                gSampledFilter[HashPtr(ptr) % kAllocFilterSlots].fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    ALLOC_TRACKER_NOINLINE inline void OnAlloc(void* ptr, size_t size, const char* category) {
+        if (ptr == nullptr) return;
+        gAllocCount.fetch_add(1, std::memory_order_relaxed);
+        gBytesAllocated.fetch_add(size, std::memory_order_relaxed);
+        gLiveBytes.fetch_add((int64_t)malloc_usable_size(ptr), std::memory_order_relaxed);
+
+        if (tInHook || --tUntilSample > 0) return;
+        tUntilSample = kAllocSampleInterval;
+        tInHook = true;
+        Sample(ptr, size, category);
+        tInHook = false;
+    }
+
+    inline void OnFree(void* ptr) {
+        if (ptr == nullptr) return;
+        gFreeCount.fetch_add(1, std::memory_order_relaxed);
+        gLiveBytes.fetch_sub((int64_t)malloc_usable_size(ptr), std::memory_order_relaxed);
+
+        // A block is only in the table if it was marked before its allocation
+        // returned, so a clear slot means there's nothing to look up
+        if (tInHook || gSampledFilter[HashPtr(ptr) % kAllocFilterSlots].load(std::memory_order_relaxed) == 0) return;
+        tInHook = true;
+        Unsample(ptr);
+        tInHook = false;
+    }
+
+    ALLOC_TRACKER_NOINLINE inline void* Allocate(size_t size, const char* category) {
+        void* ptr = malloc(size != 0 ? size : 1);
+        OnAlloc(ptr, size, category);
+        return ptr;
+    }
+
+    ALLOC_TRACKER_NOINLINE inline void* AllocateAligned(size_t size, size_t alignment, const char* category) {
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, std::max(alignment, sizeof(void*)), size != 0 ? size : 1) != 0) return nullptr;
+        OnAlloc(ptr, size, category);
+        return ptr;
+    }
+
+    ALLOC_TRACKER_NOINLINE inline void Free(void* ptr) {
+        OnFree(ptr);
+        free(ptr);
+    }
+}
+
+inline AllocStats GetAllocStats() {
+    using namespace alloc_tracker;
+    return { gAllocCount.load(), gFreeCount.load(), gBytesAllocated.load(), gLiveBytes.load() };
+}
+
+// backtrace() loads its unwinder on first use, which allocates; do that once
+// up front instead of inside the first sampled allocation
+inline void InstallAllocTracker() {
+    void* frames[2];
+    alloc_tracker::tInHook = true;
+    backtrace(frames, 2);
+    alloc_tracker::tInHook = false;
+}
+
+// Write call sites sorted by bytes as JSON. Counts and bytes are for the
+// sampled allocations; multiply by sampleInterval for estimated totals.
+inline bool WriteAllocReport(const char* path) {
+    using namespace alloc_tracker;
+    tInHook = true;
+
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        tInHook = false;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(gTableMutex);
+    AllocStats stats = GetAllocStats();
+    fprintf(file, "{\"sampleInterval\":%d,\"allocCount\":%llu,\"freeCount\":%llu,\"bytesAllocated\":%llu,\"liveBytes\":%lld,\"sites\":[",
+        kAllocSampleInterval, (unsigned long long)stats.allocCount, (unsigned long long)stats.freeCount,
+        (unsigned long long)stats.bytesAllocated, (long long)stats.liveBytes);
+
+    size_t siteCount = 0;
+    AllocSite** sorted = (AllocSite**)malloc(sizeof(AllocSite*) * kAllocMaxSites);
+    for (size_t i = 0; gSites != nullptr && sorted != nullptr && i < kAllocMaxSites; i++) {
+        if (gSites[i].count > 0) sorted[siteCount++] = &gSites[i];
+    }
+    if (sorted != nullptr) {
+        std::sort(sorted, sorted + siteCount, [](const AllocSite* a, const AllocSite* b) { return a->bytes > b->bytes; });
+    }
+
+    for (size_t i = 0; i < siteCount; i++) {
+        const AllocSite& site = *sorted[i];
+        double avgLifetimeMs = site.frees > 0 ? (double)site.lifetimeNs / site.frees / 1e6 : 0.0;
+        fprintf(file, "%s\n{\"category\":\"%s\",\"count\":%llu,\"bytes\":%llu,\"frees\":%llu,\"live\":%llu,\"avgLifetimeMs\":%.3f,\"stack\":[",
+            i == 0 ? "" : ",", site.category, (unsigned long long)site.count, (unsigned long long)site.bytes,
+            (unsigned long long)site.frees, (unsigned long long)(site.count - site.frees), avgLifetimeMs);
+
+        char** symbols = backtrace_symbols(site.frames, site.depth);
+        for (int frame = 0; frame < site.depth; frame++) {
+            fprintf(file, "%s\"", frame == 0 ? "" : ",");
+            const char* symbol = symbols != nullptr ? symbols[frame] : "?";
+            for (const char* c = symbol; *c != '\0'; c++) {
+                if (*c == '"' || *c == '\\') fputc('\\', file);
+                fputc(*c, file);
+            }
+            fputc('"', file);
+        }
+        free(symbols);
+        fprintf(file, "]}");
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    free(sorted);
+
+    tInHook = false;
+    return true;
+}
+
+// Global operator new/delete
+ALLOC_TRACKER_NOINLINE void* operator new(size_t size) {
+    void* ptr = alloc_tracker::Allocate(size, "new");
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+ALLOC_TRACKER_NOINLINE void* operator new[](size_t size) {
+    void* ptr = alloc_tracker::Allocate(size, "new");
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+ALLOC_TRACKER_NOINLINE void* operator new(size_t size, const std::nothrow_t&) noexcept { return alloc_tracker::Allocate(size, "new"); }
+ALLOC_TRACKER_NOINLINE void* operator new[](size_t size, const std::nothrow_t&) noexcept { return alloc_tracker::Allocate(size, "new"); }
+ALLOC_TRACKER_NOINLINE void* operator new(size_t size, std::align_val_t alignment) {
+    void* ptr = alloc_tracker::AllocateAligned(size, (size_t)alignment, "new");
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+ALLOC_TRACKER_NOINLINE void* operator new[](size_t size, std::align_val_t alignment) {
+    void* ptr = alloc_tracker::AllocateAligned(size, (size_t)alignment, "new");
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+ALLOC_TRACKER_NOINLINE void operator delete(void* ptr) noexcept { alloc_tracker::Free(ptr); }
+ALLOC_TRACKER_NOINLINE void operator delete[](void* ptr) noexcept { alloc_tracker::Free(ptr); }
+ALLOC_TRACKER_NOINLINE void operator delete(void* ptr, size_t) noexcept { alloc_tracker::Free(ptr); }
+ALLOC_TRACKER_NOINLINE void operator delete[](void* ptr, size_t) noexcept { alloc_tracker::Free(ptr); }
+ALLOC_TRACKER_NOINLINE void operator delete(void* ptr, std::align_val_t) noexcept { alloc_tracker::Free(ptr); }
+ALLOC_TRACKER_NOINLINE void operator delete[](void* ptr, std::align_val_t) noexcept { alloc_tracker::Free(ptr); }
+ALLOC_TRACKER_NOINLINE void operator delete(void* ptr, size_t, std::align_val_t) noexcept { alloc_tracker::Free(ptr); }
+ALLOC_TRACKER_NOINLINE void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { alloc_tracker::Free(ptr); }
+
+#else
+
+inline AllocStats GetAllocStats() { return { 0, 0, 0, 0 }; }
+inline void InstallAllocTracker() {}
+inline bool WriteAllocReport(const char*) { return false; }
+
+#endif
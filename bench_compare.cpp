@@ -0,0 +1,178 @@
+// Benchmark comparison
+// Compares two benchmark result files (see bench_results.h) metric by metric
+// and exits non-zero if any metric got significantly worse, so CI can gate
+// merges on it:
+//
+//   ./bench_compare old.json new.json [--alpha 0.05] [--threshold 2] [--seed n]
+//
+// A metric regresses when both hold:
+//   - a two-sided Mann-Whitney U test says the samples differ (p < alpha)
+//   - the bootstrap confidence interval for the change in median lies wholly
+//     above +threshold percent
+// The rank test alone would flag changes too small to matter once there are
+// enough trials. The interval alone would trust a handful of lucky samples.
+//
+// Exit status: 0 no regressions, 1 regression found, 2 bad input.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bench_results.h"
+#include "determinism.h"
+
+static double Median(std::vector<double> values) {
+    if (values.empty()) return 0.0;
+    size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    double upper = values[middle];
+    if (values.size() % 2 == 1) return upper;
+    double lower = *std::max_element(values.begin(), values.begin() + middle);
+    return 0.5 * (lower + upper);
+}
+
+// Two-sided p-value of the Mann-Whitney U test, normal approximation with
+// tie correction. Fine from about 5 samples per side.
+static double MannWhitneyP(const std::vector<double>& a, const std::vector<double>& b) {
+    struct Ranked { double value; int group; };
+    std::vector<Ranked> all;
+    for (double value : a) all.push_back({ value, 0 });
+    for (double value : b) all.push_back({ value, 1 });
+    std::sort(all.begin(), all.end(), [](const Ranked& x, const Ranked& y) { return x.value < y.value; });
+
+    double rankSumA = 0.0;
+    double tieTerm = 0.0;
+    size_t n = all.size();
+    for (size_t i = 0; i < n;) {
+        size_t j = i;
+        while (j < n && all[j].value == all[i].value) j++;
+        double rank = 0.5 * (i + 1 + j); // Average of ranks i+1..j
+        for (size_t k = i; k < j; k++) {
+            if (all[k].group == 0) rankSumA += rank;
+        }
+        double ties = (double)(j - i);
+        tieTerm += ties * ties * ties - ties;
+        i = j;
+    }
+
+    double na = (double)a.size(), nb = (double)b.size();
+    double u = rankSumA - na * (na + 1) / 2;
+    double mean = na * nb / 2;
+    double variance = na * nb / 12 * ((na + nb + 1) - tieTerm / ((na + nb) * (na + nb - 1)));
+    if (variance <= 0.0) return 1.0;
+
+    double z = (std::fabs(u - mean) - 0.5) / std::sqrt(variance); // Continuity correction
+    if (z < 0.0) z = 0.0;
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+struct Interval {
+    double low, high;
+};
+
+// Percentile bootstrap of the relative change in median, in percent
+static Interval BootstrapChange(const std::vector<double>& before, const std::vector<double>& after,
+                                double confidence, int resamples, uint64_t seed) {
+    DeterministicRandom random(seed);
+    std::vector<double> changes;
+    changes.reserve(resamples);
+    std::vector<double> sampleBefore(before.size()), sampleAfter(after.size());
+    for (int r = 0; r < resamples; r++) {
+        for (double& value : sampleBefore) value = before[random.Range(0, (int)before.size() - 1)];
+        for (double& value : sampleAfter) value = after[random.Range(0, (int)after.size() - 1)];
+        double medianBefore = Median(sampleBefore);
+        if (medianBefore == 0.0) continue;
+        changes.push_back((Median(sampleAfter) / medianBefore - 1.0) * 100.0);
+    }
+    if (changes.empty()) return { 0.0, 0.0 };
+
+    std::sort(changes.begin(), changes.end());
+    double tail = (1.0 - confidence) / 2;
+    size_t low = (size_t)(tail * (changes.size() - 1));
+    size_t high = (size_t)((1.0 - tail) * (changes.size() - 1));
+    return { changes[low], changes[high] };
+}
+
+int main(int argc, char** argv) {
+    const char* oldPath = nullptr;
+    const char* newPath = nullptr;
+    double alpha = 0.05;
+    double thresholdPercent = 2.0;
+    uint64_t seed = 1;
+    bool badArguments = false;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--alpha") == 0 && hasValue) alpha = atof(argv[++i]);
+        else if (strcmp(argv[i], "--threshold") == 0 && hasValue) thresholdPercent = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue) seed = strtoull(argv[++i], nullptr, 10);
+        else if (oldPath == nullptr) oldPath = argv[i];
+        else if (newPath == nullptr) newPath = argv[i];
+        else badArguments = true;
+    }
+    if (badArguments || oldPath == nullptr || newPath == nullptr) {
+        fprintf(stderr, "Usage: %s old.json new.json [--alpha 0.05] [--threshold 2] [--seed n]\n", argv[0]);
+        return 2;
+    }
+
+    BenchResults before, after;
+    if (!LoadBenchResults(oldPath, before)) {
+        fprintf(stderr, "Can't read %s\n", oldPath);
+        return 2;
+    }
+    if (!LoadBenchResults(newPath, after)) {
+        fprintf(stderr, "Can't read %s\n", newPath);
+        return 2;
+    }
+
+    const double confidence = 1.0 - alpha;
+    printf("%s -> %s (alpha %.3g, threshold %.3g%%)\n", oldPath, newPath, alpha, thresholdPercent);
+    printf("%-16s %12s %12s %9s %21s %9s  %s\n", "metric", "old median", "new median", "change", "confidence interval", "p", "verdict");
+
+    int regressions = 0;
+    for (const BenchMetric& metric : before.metrics) {
+        const BenchMetric* other = after.Find(metric.name);
+        if (other == nullptr) {
+            printf("%-16s missing from %s\n", metric.name.c_str(), newPath);
+            continue;
+        }
+        if (metric.samples.size() < 2 || other->samples.size() < 2) {
+            printf("%-16s needs at least 2 trials per side\n", metric.name.c_str());
+            continue;
+        }
+
+        double medianBefore = Median(metric.samples);
+        double medianAfter = Median(other->samples);
+        double change = medianBefore != 0.0 ? (medianAfter / medianBefore - 1.0) * 100.0 : 0.0;
+        double p = MannWhitneyP(metric.samples, other->samples);
+        Interval interval = BootstrapChange(metric.samples, other->samples, confidence, 5000, seed);
+
+        const char* verdict = "same";
+        if (p < alpha && interval.low > thresholdPercent) {
+            verdict = "REGRESSION";
+            regressions++;
+        } else if (p < alpha && interval.high < -thresholdPercent) {
+            verdict = "improved";
+        } else if (p < alpha) {
+            verdict = "changed, under threshold";
+        }
+
+        printf("%-16s %12.4g %12.4g %+8.2f%% [%+8.2f%%, %+8.2f%%] %9.4f  %s\n", metric.name.c_str(), medianBefore,
+            medianAfter, change, interval.low, interval.high, p, verdict);
+    }
+
+    for (const BenchMetric& metric : after.metrics) {
+        if (before.Find(metric.name) == nullptr) printf("%-16s new in %s, not compared\n", metric.name.c_str(), newPath);
+    }
+
+    if (regressions > 0) {
+        printf("%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+        return 1;
+    }
+    printf("No regressions\n");
+    return 0;
+}
@@ -0,0 +1,153 @@
+// Benchmark results
+// The file a headless benchmark writes and bench_compare reads. It holds one
+// sample per trial for each metric, so a comparison can tell real changes from
+// run-to-run noise:
+//
+//   {
+//     "name": "demo_3d",
+//     "metrics": {
+//       "frame_ms": [4.12, 4.09, 4.20],
+//       "step_ms": [2.31, 2.28, 2.35]
+//     }
+//   }
+//
+// Every metric is lower-is-better (times, bytes). The reader only understands
+// this shape, not JSON in general.
+
+#pragma once
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct BenchMetric {
+    std::string name;
+    std::vector<double> samples; // One per trial
+};
+
+struct BenchResults {
+    std::string name;
+    std::vector<BenchMetric> metrics; // In insertion order
+
+    std::vector<double>& Samples(const std::string& metric) {
+        for (BenchMetric& entry : metrics) {
+            if (entry.name == metric) return entry.samples;
+        }
+        metrics.push_back({ metric, {} });
+        return metrics.back().samples;
+    }
+
+    const BenchMetric* Find(const std::string& metric) const {
+        for (const BenchMetric& entry : metrics) {
+            if (entry.name == metric) return &entry;
+        }
+        return nullptr;
+    }
+};
+
+inline bool SaveBenchResults(const BenchResults& results, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) return false;
+
+    fprintf(file, "{\n  \"name\": \"%s\",\n  \"metrics\": {\n", results.name.c_str());
+    for (size_t m = 0; m < results.metrics.size(); m++) {
+        const BenchMetric& metric = results.metrics[m];
+        fprintf(file, "    \"%s\": [", metric.name.c_str());
+        for (size_t i = 0; i < metric.samples.size(); i++) {
+            fprintf(file, "%s%.9g", i > 0 ? ", " : "", metric.samples[i]);
+        }
+        fprintf(file, "]%s\n", m + 1 < results.metrics.size() ? "," : "");
+    }
+    fprintf(file, "  }\n}\n");
+    fclose(file);
+    return true;
+}
+
+namespace bench_detail {
+
+struct Reader {
+    const std::string& text;
+    size_t pos;
+
+    void SkipSpace() {
+        while (pos < text.size() && isspace((unsigned char)text[pos])) pos++;
+    }
+
+    bool Expect(char c) {
+        SkipSpace();
+        if (pos >= text.size() || text[pos] != c) return false;
+        pos++;
+        return true;
+    }
+
+    bool Peek(char c) {
+        SkipSpace();
+        return pos < text.size() && text[pos] == c;
+    }
+
+    bool String(std::string& out) {
+        if (!Expect('"')) return false;
+        size_t end = text.find('"', pos);
+        if (end == std::string::npos) return false;
+        out = text.substr(pos, end - pos);
+        pos = end + 1;
+        return true;
+    }
+
+    bool Number(double& out) {
+        SkipSpace();
+        const char* start = text.c_str() + pos;
+        char* end;
+        out = strtod(start, &end);
+        if (end == start) return false;
+        pos += end - start;
+        return true;
+    }
+};
+
+} // namespace bench_detail
+
+inline bool LoadBenchResults(const char* path, BenchResults& results) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) return false;
+    std::string text;
+    char chunk[4096];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) text.append(chunk, count);
+    fclose(file);
+
+    bench_detail::Reader reader{ text, 0 };
+    results = BenchResults();
+    if (!reader.Expect('{')) return false;
+    while (!reader.Peek('}')) {
+        std::string key;
+        if (!reader.String(key) || !reader.Expect(':')) return false;
+
+        if (key == "name") {
+            if (!reader.String(results.name)) return false;
+        } else if (key == "metrics") {
+            if (!reader.Expect('{')) return false;
+            while (!reader.Peek('}')) {
+                std::string metric;
+                if (!reader.String(metric) || !reader.Expect(':') || !reader.Expect('[')) return false;
+                std::vector<double>& samples = results.Samples(metric);
+                while (!reader.Peek(']')) {
+                    double value;
+                    if (!reader.Number(value)) return false;
+                    samples.push_back(value);
+                    reader.Expect(',');
+                }
+                reader.Expect(']');
+                reader.Expect(',');
+            }
+            reader.Expect('}');
+        } else {
+            return false;
+        }
+        reader.Expect(',');
+    }
+    return true;
+}
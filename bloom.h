@@ -0,0 +1,119 @@
+// Bloom
+// Glow as a post-process instead of extra shapes drawn per glowing entity.
+// Entities with an emissive color draw it into a half-resolution target
+// cleared to black; the passes added here then:
+//   - downsample it to 1/4 and 1/8 of the screen, letting bilinear filtering
+//     average the texels
+//   - blur both levels with a separable 9-tap Gaussian, a horizontal pass
+//     then a vertical one
+// The composite adds both blurred levels over the scene. The 1/8 level gives
+// the wide halo and the 1/4 level keeps it bright near its source.
+//
+// Emissive shapes are one batched draw for all of them. Everything after that
+// is a fixed set of small full-screen passes, so glow costs the same whether
+// one entity glows or a hundred. Intermediate targets are transient, and the
+// render graph aliases the ones whose lifetimes don't overlap.
+
+#pragma once
+
+#include "raylib.h"
+#include "render_graph.h"
+
+// Fragment shader for raylib's default vertex shader. The 9 Gaussian taps are
+// folded into 5 fetches by sampling between texel pairs.
+constexpr const char* kBloomBlurShader = R"(#version 330
+in vec2 fragTexCoord;
+in vec4 fragColor;
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;
+uniform vec2 direction; // One texel along the blur axis
+out vec4 finalColor;
+
+const float offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main() {
+    vec3 sum = texture(texture0, fragTexCoord).rgb * weights[0];
+    for (int i = 1; i < 3; i++) {
+        sum += texture(texture0, fragTexCoord + direction * offsets[i]).rgb * weights[i];
+        sum += texture(texture0, fragTexCoord - direction * offsets[i]).rgb * weights[i];
+    }
+    finalColor = vec4(sum, 1.0) * colDiffuse * fragColor;
+}
+)";
+
+// Blurred levels for the composite to add over the scene
+struct BloomTargets {
+    int wide = -1;  // 1/8 resolution
+    int tight = -1; // 1/4 resolution
+};
+
+class Bloom {
+public:
+    // Needs the GL context, so call after InitWindow
+    void Load() {
+        mShader = LoadShaderFromMemory(nullptr, kBloomBlurShader);
+        mDirectionLoc = GetShaderLocation(mShader, "direction");
+    }
+
+    void Unload() {
+        if (IsShaderValid(mShader)) UnloadShader(mShader);
+        mShader = Shader();
+    }
+
+    bool IsLoaded() const { return IsShaderValid(mShader); }
+
+    // Add the downsample and blur passes reading the emissive target. Passes
+    // are culled by the graph if the composite doesn't read the result.
+    BloomTargets AddPasses(RenderGraph& graph, int emissive) {
+        int quarter = graph.AddTarget("bloom_quarter", 0.25f);
+        int eighth = graph.AddTarget("bloom_eighth", 0.125f);
+        graph.AddPass("bloom_down_quarter", { emissive }, quarter, true, BLACK,
+                      [&graph, emissive, quarter]() { Copy(graph, emissive, quarter); });
+        graph.AddPass("bloom_down_eighth", { quarter }, eighth, true, BLACK,
+                      [&graph, quarter, eighth]() { Copy(graph, quarter, eighth); });
+
+        BloomTargets targets;
+        targets.tight = AddBlur(graph, quarter, 0.25f);
+        targets.wide = AddBlur(graph, eighth, 0.125f);
+        return targets;
+    }
+
+    // Add a level over whatever is drawn, for the composite pass
+    static void Composite(const RenderGraph& graph, int level, Rectangle dest, float strength) {
+        BeginBlendMode(BLEND_ADDITIVE);
+        DrawRenderTarget(graph.GetTexture(level), dest, Fade(WHITE, strength));
+        EndBlendMode();
+    }
+
+private:
+    // Stretch one target over another of a different size
+    static void Copy(const RenderGraph& graph, int source, int dest) {
+        const Texture2D& from = graph.GetTexture(source);
+        const Texture2D& to = graph.GetTexture(dest);
+        DrawRenderTarget(from, { 0.0f, 0.0f, (float)to.width, (float)to.height }, WHITE);
+    }
+
+    // Horizontal then vertical blur, returning the target with the result
+    int AddBlur(RenderGraph& graph, int source, float scale) {
+        int horizontal = graph.AddTarget("bloom_blur_h", scale);
+        int vertical = graph.AddTarget("bloom_blur_v", scale);
+        graph.AddPass("bloom_blur_h", { source }, horizontal, false, BLANK,
+                      [this, &graph, source]() { Blur(graph, source, 1.0f, 0.0f); });
+        graph.AddPass("bloom_blur_v", { horizontal }, vertical, false, BLANK,
+                      [this, &graph, horizontal]() { Blur(graph, horizontal, 0.0f, 1.0f); });
+        return vertical;
+    }
+
+    void Blur(const RenderGraph& graph, int source, float x, float y) {
+        const Texture2D& texture = graph.GetTexture(source);
+        float direction[2] = { x / texture.width, y / texture.height };
+        SetShaderValue(mShader, mDirectionLoc, direction, SHADER_UNIFORM_VEC2);
+        BeginShaderMode(mShader);
+        DrawRenderTarget(texture, { 0.0f, 0.0f, (float)texture.width, (float)texture.height }, WHITE);
+        EndShaderMode();
+    }
+
+    Shader mShader = {};
+    int mDirectionLoc = -1;
+};
@@ -6,6 +6,27 @@ cd "$PROJECT_DIR"
 
 JOBS=$(nproc)
 
+# Extra flags for the game builds
+# ALLOC_TRACKING=1 compiles in the allocation tracker (alloc_tracker.h)
+# PGO=generate|use builds an instrumented binary or uses its profile
+# DETERMINISTIC=1 builds against Jolt's cross-platform deterministic mode
+GAME_FLAGS=()
+if [ "${ALLOC_TRACKING:-0}" = "1" ]; then
+    GAME_FLAGS+=(-DLEVELFORGE_ALLOC_TRACKING -rdynamic)
+fi
+case "${PGO:-}" in
+    generate) GAME_FLAGS+=(-fprofile-generate) ;;
+    use)      GAME_FLAGS+=(-fprofile-use -fprofile-correction) ;;
+esac
+
+JOLT_BUILD_DIR="Linux_Release"
+JOLT_CMAKE_FLAGS=()
+if [ "${DETERMINISTIC:-0}" = "1" ]; then
+    JOLT_BUILD_DIR="Linux_Deterministic"
+    JOLT_CMAKE_FLAGS+=(-DCROSS_PLATFORM_DETERMINISTIC=ON)
+    GAME_FLAGS+=(-DJPH_CROSS_PLATFORM_DETERMINISTIC -ffp-contract=off)
+fi
+
 # Colors
 RED='\033[0;31m'
 GREEN='\033[0;32m'
@@ -62,7 +83,7 @@ build_box2d() {
 }
 
 build_jolt() {
-    if [ -f "jolt/Build/Linux_Release/libJolt.a" ]; then
+    if [ -f "jolt/Build/$JOLT_BUILD_DIR/libJolt.a" ]; then
         log_info "jolt already built, skipping..."
         return 0
     fi
@@ -70,10 +91,11 @@ build_jolt() {
     log_info "Building jolt..."
     cd jolt/Build
 
-    cmake -S . -B Linux_Release -G "Unix Makefiles" \
+    cmake -S . -B "$JOLT_BUILD_DIR" -G "Unix Makefiles" \
         -DCMAKE_BUILD_TYPE=Release \
-        -DCMAKE_CXX_COMPILER=g++
-    make -C Linux_Release -j"$JOBS"
+        -DCMAKE_CXX_COMPILER=g++ \
+        "${JOLT_CMAKE_FLAGS[@]}"
+    make -C "$JOLT_BUILD_DIR" -j"$JOBS"
 
     cd "$PROJECT_DIR"
     log_info "jolt built successfully"
@@ -116,6 +138,7 @@ build_game_2d() {
         -I./raylib/include \
         -I./box2d/include \
         -I./yaml/include \
+        "${GAME_FLAGS[@]}" \
         -L./raylib/lib \
         -L./"$BOX2D_LIB_DIR" \
         -L./yaml/lib \
@@ -138,10 +161,11 @@ build_game_3d() {
         -DJPH_PROFILE_ENABLED \
         -DJPH_DEBUG_RENDERER \
         -DJPH_OBJECT_STREAM \
+        "${GAME_FLAGS[@]}" \
         -I./raylib/include \
         -I./jolt \
         -L./raylib/lib \
-        -L./jolt/Build/Linux_Release \
+        -L./jolt/Build/"$JOLT_BUILD_DIR" \
         -l:libraylib.a \
         -l:libJolt.a \
         -lGL -lm -lpthread -ldl -lrt -lX11
@@ -155,13 +179,21 @@ build_demo_3d() {
     build_game_3d "demo_3d.cpp" "demo_3d"
 }
 
+# Standalone helpers with no library dependencies
+build_tools() {
+    log_info "Building tools..."
+    g++ -std=c++17 -O2 metrics_receiver.cpp -o metrics_receiver
+    g++ -std=c++17 -O2 bench_compare.cpp -o bench_compare
+    log_info "Tools built: ./metrics_receiver ./bench_compare"
+}
+
 # ============================================================================
 # Clean Functions
 # ============================================================================
 
 clean_raylib() { rm -rf raylib/build raylib/lib raylib/include; }
 clean_box2d()  { rm -rf box2d/build box2d/lib64 box2d/lib; }
-clean_jolt()   { rm -rf jolt/Build/Linux_Release jolt/Build/Linux_Debug; }
+clean_jolt()   { rm -rf jolt/Build/Linux_Release jolt/Build/Linux_Debug jolt/Build/Linux_Deterministic; }
 clean_yaml()   { rm -rf yaml/build yaml/lib; }
 
 clean_2d() {
@@ -286,6 +318,7 @@ usage() {
     echo "  2d          Build 2D game (raylib + box2d)"
     echo "  3d          Build 3D game (raylib + jolt)"
     echo "  demo        Build 3D demo (tennis target game)"
+    echo "  tools       Build helper tools (metrics_receiver, bench_compare)"
     echo ""
     echo "Commands (optional):"
     echo "  <file.cpp>  Build specific source file (output name derived from filename)"
@@ -297,6 +330,12 @@ usage() {
     echo "  clean-all   Remove all build artifacts"
     echo "  help        Show this message"
     echo ""
+    echo "Environment:"
+    echo "  ALLOC_TRACKING=1  Build with the allocation tracker (writes alloc_report.json on exit)"
+    echo "  PGO=generate      Build instrumented for profile-guided optimization"
+    echo "  PGO=use           Build using the profile from a PGO=generate run"
+    echo "  DETERMINISTIC=1   Build Jolt and the game in cross-platform deterministic mode"
+    echo ""
     echo "Examples:"
     echo "  $0 2d                  # Build main.cpp as 2D game"
     echo "  $0 3d                  # Build main.cpp as 3D game"
@@ -305,6 +344,10 @@ usage() {
     echo "  $0 demo                # Build 3D tennis demo"
     echo "  $0 2d rebuild          # Clean rebuild 2D"
     echo "  $0 3d update           # Update and rebuild 3D"
+    echo "  ALLOC_TRACKING=1 $0 demo   # Build the demo with allocation tracking"
+    echo "  DETERMINISTIC=1 $0 demo    # Then: ./demo_3d --verify-determinism --trace-out o2.trace"
+    echo "  $0 tools                   # Then: ./metrics_receiver & LEVELFORGE_METRICS=udp:127.0.0.1:8125 ./demo_3d"
+    echo "  $0 tools                   # Then: ./bench_compare old.json new.json (from ./demo_3d --bench <file>)"
 }
 
 # ============================================================================
@@ -335,6 +378,9 @@ case "${1:-}" in
     demo)
         build_demo_3d
         ;;
+    tools)
+        build_tools
+        ;;
     clean-all)
         clean_all
         ;;
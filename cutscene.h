@@ -0,0 +1,398 @@
+// Cutscenes
+// Backs the `cutscene` screen type. A timeline of cues (camera moves, entity
+// animations, text and audio) is compiled into one stream of events sorted by
+// time. Playback walks a cursor along it, so each frame only touches the
+// events it crosses.
+//
+// Assets are streamed instead of loaded up front. Compiling groups each
+// asset's uses into spans and adds a load event kCutscenePreloadSeconds
+// before a span's first cue and a release event after its last. Files are read
+// and decoded on a worker thread; the main thread only uploads the decoded
+// result. Memory stays bounded by what is in use or about to be, however long
+// the cutscene runs. An asset that isn't ready by its cue starts late rather
+// than stalling the frame; those are counted and reported.
+//
+// Audio is the only streamed asset type so far, and is skipped when no audio
+// device is open.
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "raylib.h"
+#include "raymath.h"
+
+constexpr float kCutscenePreloadSeconds = 2.0f; // Load this far ahead of a cue
+
+enum class CueType { Camera, Animate, Text, Audio };
+
+struct CutsceneCue {
+    CueType type = CueType::Text;
+    float time = 0.0f;      // Start, in seconds from the beginning
+    float duration = 0.0f;  // Audio plays to its end whatever this says
+    std::string target;     // Animate: entity id
+    std::string text;       // Text: content
+    std::string asset;      // Audio: sound file
+    Vector3 from = { 0.0f, 0.0f, 0.0f };       // Camera or entity position
+    Vector3 to = { 0.0f, 0.0f, 0.0f };
+    Vector3 lookFrom = { 0.0f, 0.0f, 0.0f };   // Camera only: target
+    Vector3 lookTo = { 0.0f, 0.0f, 0.0f };
+};
+
+// Same-time events run in this order: ends before begins, so back to back
+// cues hand over cleanly, and releases before loads to keep the peak down
+enum class CutsceneEventKind { End, Release, Load, Begin };
+
+struct CutsceneEvent {
+    float time;
+    CutsceneEventKind kind;
+    int index; // Cue for Begin/End, asset for Load/Release
+};
+
+struct CompiledCutscene {
+    std::vector<CutsceneCue> cues;
+    std::vector<std::string> assets; // One per span, so a path can repeat
+    std::vector<int> cueAsset;       // Asset used by each cue, or -1
+    std::vector<CutsceneEvent> events;
+    float length = 0.0f;
+};
+
+inline CompiledCutscene CompileCutscene(std::vector<CutsceneCue> cues, float preloadSeconds = kCutscenePreloadSeconds) {
+    CompiledCutscene scene;
+    std::stable_sort(cues.begin(), cues.end(), [](const CutsceneCue& a, const CutsceneCue& b) { return a.time < b.time; });
+    scene.cues = std::move(cues);
+    scene.cueAsset.assign(scene.cues.size(), -1);
+
+    struct Span {
+        std::string path;
+        float start, end;
+    };
+    std::vector<Span> spans;
+    for (size_t i = 0; i < scene.cues.size(); i++) {
+        const CutsceneCue& cue = scene.cues[i];
+        float end = cue.time + cue.duration;
+        scene.length = std::max(scene.length, end);
+        scene.events.push_back({ cue.time, CutsceneEventKind::Begin, (int)i });
+        if (cue.duration > 0.0f) scene.events.push_back({ end, CutsceneEventKind::End, (int)i });
+        if (cue.asset.empty()) continue;
+
+        // Reuse the asset's latest span if this cue starts before it would
+        // have been released and loaded again anyway
+        int spanIndex = -1;
+        for (int s = (int)spans.size() - 1; s >= 0; s--) {
+            if (spans[s].path == cue.asset) {
+                if (cue.time - spans[s].end <= 2.0f * preloadSeconds) spanIndex = s;
+                break;
+            }
+        }
+        if (spanIndex < 0) {
+            spans.push_back({ cue.asset, cue.time, end });
+            spanIndex = (int)spans.size() - 1;
+        }
+        spans[spanIndex].end = std::max(spans[spanIndex].end, end);
+        scene.cueAsset[i] = spanIndex;
+    }
+
+    for (size_t s = 0; s < spans.size(); s++) {
+        scene.assets.push_back(spans[s].path);
+        scene.events.push_back({ std::max(0.0f, spans[s].start - preloadSeconds), CutsceneEventKind::Load, (int)s });
+        scene.events.push_back({ spans[s].end, CutsceneEventKind::Release, (int)s });
+    }
+
+    std::stable_sort(scene.events.begin(), scene.events.end(), [](const CutsceneEvent& a, const CutsceneEvent& b) {
+        return a.time != b.time ? a.time < b.time : a.kind < b.kind;
+    });
+    return scene;
+}
+
+// 0..1 through a cue, eased in and out
+inline float CueProgress(const CutsceneCue& cue, float time) {
+    if (cue.duration <= 0.0f) return 1.0f;
+    float t = Clamp((time - cue.time) / cue.duration, 0.0f, 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// Reads and decodes sounds on a worker thread, uploads them on the main thread
+class CutsceneAssetStreamer {
+public:
+    ~CutsceneAssetStreamer() { Stop(); }
+
+    void Start(size_t assetCount) {
+        Stop();
+        mAssets.assign(assetCount, Asset());
+        mResidentBytes = 0;
+        mPeakBytes = 0;
+        mLateCues = 0;
+        mQuit = false;
+        mWorker = std::thread(&CutsceneAssetStreamer::WorkerLoop, this);
+    }
+
+    // Unload everything, including sounds still playing
+    void Stop() {
+        if (mWorker.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mQuit = true;
+            }
+            mWake.notify_one();
+            mWorker.join();
+        }
+        for (Decoded& decoded : mDecoded) UnloadWave(decoded.wave);
+        mDecoded.clear();
+        mRequests.clear();
+        // Stop sounds still playing before their buffers are freed, so the
+        // audio thread never mixes from an unloaded buffer
+        for (size_t i = 0; i < mAssets.size(); i++) {
+            if (mAssets[i].ready && IsSoundPlaying(mAssets[i].sound)) StopSound(mAssets[i].sound);
+            Unload((int)i);
+        }
+    }
+
+    void Request(int index, const std::string& path) {
+        if (!IsAudioDeviceReady()) return;
+        mAssets[index].requested = true;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mRequests.push_back({ index, path });
+        }
+        mWake.notify_one();
+    }
+
+    // Unloaded once it has finished playing
+    void Release(int index) { mAssets[index].released = true; }
+
+    // Start the sound now, or as soon as it arrives if it's late
+    void Play(int index) {
+        Asset& asset = mAssets[index];
+        if (!asset.requested) return;
+        if (asset.ready) {
+            PlaySound(asset.sound);
+        } else {
+            asset.playWhenReady = true;
+            mLateCues++;
+        }
+    }
+
+    // Main thread, once per frame: upload finished decodes, unload released sounds
+    void Update() {
+        std::deque<Decoded> decoded;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            decoded.swap(mDecoded);
+        }
+        for (Decoded& entry : decoded) {
+            Asset& asset = mAssets[entry.index];
+            if (entry.wave.frameCount > 0) {
+                asset.sound = LoadSoundFromWave(entry.wave);
+                asset.bytes = (size_t)entry.wave.frameCount * entry.wave.channels * entry.wave.sampleSize / 8;
+                asset.ready = true;
+                mResidentBytes += asset.bytes;
+                mPeakBytes = std::max(mPeakBytes, mResidentBytes);
+                if (asset.playWhenReady) PlaySound(asset.sound);
+            }
+            UnloadWave(entry.wave);
+        }
+
+        for (size_t i = 0; i < mAssets.size(); i++) {
+            Asset& asset = mAssets[i];
+            if (asset.released && asset.ready && !IsSoundPlaying(asset.sound)) Unload((int)i);
+        }
+    }
+
+    size_t GetResidentBytes() const { return mResidentBytes; }
+    size_t GetPeakBytes() const { return mPeakBytes; }
+    int GetLateCues() const { return mLateCues; }
+
+private:
+    struct Asset {
+        Sound sound = {};
+        size_t bytes = 0;
+        bool requested = false;
+        bool ready = false;
+        bool released = false;
+        bool playWhenReady = false;
+    };
+
+    struct LoadRequest {
+        int index;
+        std::string path;
+    };
+
+    struct Decoded {
+        int index;
+        Wave wave;
+    };
+
+    void Unload(int index) {
+        Asset& asset = mAssets[index];
+        if (asset.ready) {
+            UnloadSound(asset.sound);
+            mResidentBytes -= asset.bytes;
+        }
+        asset.ready = false;
+        asset.bytes = 0;
+    }
+
+    void WorkerLoop() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true) {
+            mWake.wait(lock, [this]() { return mQuit || !mRequests.empty(); });
+            if (mQuit) return;
+            LoadRequest request = std::move(mRequests.front());
+            mRequests.pop_front();
+            lock.unlock();
+
+            Decoded decoded = { request.index, Wave() };
+            int size = 0;
+            unsigned char* data = LoadFileData(request.path.c_str(), &size);
+            if (data != nullptr) {
+                decoded.wave = LoadWaveFromMemory(GetFileExtension(request.path.c_str()), data, size);
+                UnloadFileData(data);
+            }
+            if (decoded.wave.frameCount == 0) fprintf(stderr, "Cutscene: can't load %s\n", request.path.c_str());
+
+            lock.lock();
+            mDecoded.push_back(decoded);
+        }
+    }
+
+    // Main thread only
+    std::vector<Asset> mAssets;
+    size_t mResidentBytes = 0;
+    size_t mPeakBytes = 0;
+    int mLateCues = 0;
+
+    // Shared, guarded by mMutex
+    std::thread mWorker;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::deque<LoadRequest> mRequests;
+    std::deque<Decoded> mDecoded;
+    bool mQuit = false;
+};
+
+class CutscenePlayer {
+public:
+    void Start(const CompiledCutscene& scene) {
+        mScene = &scene;
+        mTime = 0.0f;
+        mCursor = 0;
+        mActive.clear();
+        mCameraCue = -1;
+        mEntityCues.clear();
+        mStreamer.Start(scene.assets.size());
+        Update(0.0f);
+    }
+
+    // Advance the clock and run the events it passes. Returns false once the
+    // cutscene has finished.
+    bool Update(float dt) {
+        if (mScene == nullptr) return false;
+        mTime += dt;
+        const std::vector<CutsceneEvent>& events = mScene->events;
+        while (mCursor < events.size() && events[mCursor].time <= mTime) {
+            Run(events[mCursor]);
+            mCursor++;
+        }
+        mStreamer.Update();
+
+        if (mCursor < events.size()) return true;
+        Finish();
+        return false;
+    }
+
+    void Skip() { Finish(); }
+
+    bool IsPlaying() const { return mScene != nullptr; }
+    float GetTime() const { return mTime; }
+
+    // Pose from the latest camera cue, held after it ends. False before the first.
+    bool GetCamera(Vector3& position, Vector3& target) const {
+        if (mScene == nullptr || mCameraCue < 0) return false;
+        const CutsceneCue& cue = mScene->cues[mCameraCue];
+        float t = CueProgress(cue, mTime);
+        position = Vector3Lerp(cue.from, cue.to, t);
+        target = Vector3Lerp(cue.lookFrom, cue.lookTo, t);
+        return true;
+    }
+
+    // Position from the latest animate cue for the entity. False if it has none.
+    bool GetEntityPosition(const std::string& id, Vector3& position) const {
+        if (mScene == nullptr) return false;
+        for (int index : mEntityCues) {
+            const CutsceneCue& cue = mScene->cues[index];
+            if (cue.target != id) continue;
+            position = Vector3Lerp(cue.from, cue.to, CueProgress(cue, mTime));
+            return true;
+        }
+        return false;
+    }
+
+    // Text cues centered in the lower third, fading in and out
+    void DrawCaptions(int fontSize, Color color) const {
+        if (mScene == nullptr) return;
+        int y = GetScreenHeight() * 2 / 3;
+        for (int index : mActive) {
+            const CutsceneCue& cue = mScene->cues[index];
+            if (cue.type != CueType::Text) continue;
+            float fadeIn = Clamp((mTime - cue.time) / 0.3f, 0.0f, 1.0f);
+            float fadeOut = Clamp((cue.time + cue.duration - mTime) / 0.3f, 0.0f, 1.0f);
+            int width = MeasureText(cue.text.c_str(), fontSize);
+            DrawText(cue.text.c_str(), (GetScreenWidth() - width) / 2, y, fontSize, Fade(color, std::min(fadeIn, fadeOut)));
+            y += fontSize + fontSize / 2;
+        }
+    }
+
+    const CutsceneAssetStreamer& GetStreamer() const { return mStreamer; }
+
+private:
+    void Run(const CutsceneEvent& event) {
+        switch (event.kind) {
+        case CutsceneEventKind::Load:
+            mStreamer.Request(event.index, mScene->assets[event.index]);
+            break;
+        case CutsceneEventKind::Release:
+            mStreamer.Release(event.index);
+            break;
+        case CutsceneEventKind::Begin: {
+            const CutsceneCue& cue = mScene->cues[event.index];
+            if (cue.duration > 0.0f) mActive.push_back(event.index);
+            if (cue.type == CueType::Camera) mCameraCue = event.index;
+            if (cue.type == CueType::Audio && mScene->cueAsset[event.index] >= 0) mStreamer.Play(mScene->cueAsset[event.index]);
+            if (cue.type == CueType::Animate) {
+                // Latest cue per entity wins
+                mEntityCues.erase(std::remove_if(mEntityCues.begin(), mEntityCues.end(),
+                    [&](int other) { return mScene->cues[other].target == cue.target; }), mEntityCues.end());
+                mEntityCues.push_back(event.index);
+            }
+            break;
+        }
+        case CutsceneEventKind::End:
+            mActive.erase(std::remove(mActive.begin(), mActive.end(), event.index), mActive.end());
+            break;
+        }
+    }
+
+    void Finish() {
+        if (mScene == nullptr) return;
+        mStreamer.Stop();
+        printf("Cutscene: %.1f s, peak streamed audio %.1f MB, %d cues started late\n", mTime,
+            mStreamer.GetPeakBytes() / (1024.0 * 1024.0), mStreamer.GetLateCues());
+        mScene = nullptr;
+    }
+
+    const CompiledCutscene* mScene = nullptr;
+    float mTime = 0.0f;
+    size_t mCursor = 0;
+    std::vector<int> mActive;     // Cues with a duration, between their begin and end
+    int mCameraCue = -1;
+    std::vector<int> mEntityCues; // Latest animate cue per entity
+    CutsceneAssetStreamer mStreamer;
+};
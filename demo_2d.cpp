@@ -2,9 +2,30 @@
 // A classic brick-breaking game with physics
 
 #include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
 #include "box2d/box2d.h"
+#include <cmath>
 #include <vector>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <ctime>
+
+#include "alloc_tracker.h"
+#include "bloom.h"
+#include "determinism.h"
+#include "entity_costs.h"
+#include "explosion.h"
+#include "frame_capture.h"
+#include "frame_profiler.h"
+#include "metrics.h"
+#include "parallel_for.h"
+#include "render_graph.h"
+#include "ui_layout.h"
 
 // Screen dimensions
 const int SCREEN_WIDTH = 800;
@@ -12,6 +33,7 @@ const int SCREEN_HEIGHT = 600;
 
 // Physics scale (pixels per meter)
 const float SCALE = 30.0f;
+const float PIXEL = 1.0f / SCALE; // One screen pixel in meters at zoom 1
 
 // Game dimensions in physics units (meters)
 const float WORLD_WIDTH = SCREEN_WIDTH / SCALE;
@@ -35,22 +57,167 @@ const int BRICK_COLS = 10;
 const float BRICK_START_Y = WORLD_HEIGHT - 4.0f;
 const float BRICK_SPACING = 0.15f;
 
-// Coordinate conversion functions
-float toScreenX(float x) {
-    return x * SCALE;
+// Debris settings. Broken bricks are swapped for pieces taken from a fixed
+// pool of disabled bodies, so destruction never creates bodies mid-game.
+const int DEBRIS_POOL_SIZE = 192;
+const int DEBRIS_COLUMNS = 3;
+const int DEBRIS_ROWS = 2;
+const float DEBRIS_LIFETIME = 1.2f;     // Seconds before a piece returns to the pool
+const float DEBRIS_SPRAY_SPEED = 4.0f;
+const float DEBRIS_CULL_MARGIN = 2.0f;  // Pieces this far outside the play area are culled
+
+// Emissive colors, drawn into the bloom instead of as extra glow shapes.
+// BLANK means the entity doesn't glow.
+const Color PADDLE_EMISSIVE = (Color){ 120, 120, 255, 255 };
+const Color BALL_EMISSIVE = (Color){ 255, 255, 160, 255 };
+const float BLOOM_STRENGTH = 0.9f;
+
+// Explosion triggered with E, centered on the ball unless --explode gives one
+const float EXPLOSION_RADIUS = 3.0f;
+const float EXPLOSION_IMPULSE = 4.0f;   // Per meter of exposed perimeter
+
+// Collision categories. Debris only bounces off the walls, so it never
+// disturbs the ball or costs broadphase pairs against the bricks.
+const uint64_t CATEGORY_WALL = 0x0002;
+const uint64_t CATEGORY_DEBRIS = 0x0004;
+
+// Triangles raylib emits for the primitives drawn below (outlines are lines)
+const int RECT_TRIANGLES = 2;
+const int CIRCLE_TRIANGLES = 36;
+
+// Entity types for cost attribution, in registration order
+enum EntityType {
+    ENTITY_PADDLE,
+    ENTITY_BALL,
+    ENTITY_BRICK,
+    ENTITY_WALL,
+    ENTITY_DEBRIS,
+};
+
+// Input buttons, one bit each, so sessions can be recorded and replayed
+const uint32_t BUTTON_LEFT = 1 << 0;
+const uint32_t BUTTON_RIGHT = 1 << 1;
+const uint32_t BUTTON_LAUNCH = 1 << 2;  // Pressed this tick
+const uint32_t BUTTON_RESTART = 1 << 3; // Pressed this tick
+const uint32_t BUTTON_EXPLODE = 1 << 4; // Pressed this tick
+
+// World camera
+// The game is drawn in world space (meters, y up). The camera's view matrix
+// maps that to screen pixels and is loaded as the modelview, so the vertex
+// shader does the transform and draw calls take body positions as they are.
+// Zoom costs nothing per object and nothing is rounded to whole pixels.
+struct WorldCamera {
+    b2Vec2 center;   // World point shown at the middle of the screen
+    float zoom;      // 1 fits the whole play area
+    float smoothing; // Fraction of the way to the target per 60 Hz frame, 1 snaps
+};
+
+WorldCamera makeArenaCamera() {
+    return { (b2Vec2){ WORLD_WIDTH / 2.0f, WORLD_HEIGHT / 2.0f }, 1.0f, 0.1f };
+}
+
+// Ease towards the target, keeping the view inside the play area
+void followCamera(WorldCamera& camera, b2Vec2 target, float zoom, float dt) {
+    float t = 1.0f - powf(1.0f - camera.smoothing, dt * 60.0f);
+    camera.zoom += (zoom - camera.zoom) * t;
+    camera.center.x += (target.x - camera.center.x) * t;
+    camera.center.y += (target.y - camera.center.y) * t;
+
+    float halfWidth = WORLD_WIDTH / (2.0f * camera.zoom);
+    float halfHeight = WORLD_HEIGHT / (2.0f * camera.zoom);
+    camera.center.x = Clamp(camera.center.x, halfWidth, WORLD_WIDTH - halfWidth);
+    camera.center.y = Clamp(camera.center.y, halfHeight, WORLD_HEIGHT - halfHeight);
 }
 
-float toScreenY(float y) {
-    return SCREEN_HEIGHT - (y * SCALE);
+// Like BeginMode2D, but with y flipped, which Camera2D can't express. The
+// flip reverses triangle winding, so culling is off while it's active. The
+// arena is fitted to the window, whatever its size. Targets smaller than the
+// window pass their fraction of it as resolution.
+void beginWorldMode(const WorldCamera& camera, float resolution = 1.0f) {
+    float width = GetScreenWidth() * resolution;
+    float height = GetScreenHeight() * resolution;
+    float fit = std::min(width / SCREEN_WIDTH, height / SCREEN_HEIGHT);
+    float scale = SCALE * camera.zoom * fit;
+    Matrix view = {
+        scale, 0.0f, 0.0f, width / 2.0f - camera.center.x * scale,
+        0.0f, -scale, 0.0f, height / 2.0f + camera.center.y * scale,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f,
+    };
+    rlDrawRenderBatchActive();
+    rlLoadIdentity();
+    rlMultMatrixf(MatrixToFloat(view));
+    rlDisableBackfaceCulling();
 }
 
+void endWorldMode() {
+    rlDrawRenderBatchActive();
+    rlLoadIdentity();
+    rlEnableBackfaceCulling();
+}
+
+// Axis-aligned rectangle from its center, in world space
+Rectangle worldRect(b2Vec2 center, float width, float height) {
+    return { center.x - width / 2.0f, center.y - height / 2.0f, width, height };
+}
+
+// Destructible component: the entity breaks into a grid of pooled debris
+// pieces. The piece size must match the pool's, so the grid is fixed per
+// entity type.
+struct Destructible {
+    int columns;
+    int rows;
+    float lifetime;
+    float spraySpeed;
+};
+
+const Destructible BRICK_DESTRUCTIBLE = { DEBRIS_COLUMNS, DEBRIS_ROWS, DEBRIS_LIFETIME, DEBRIS_SPRAY_SPEED };
+
 // Brick data structure
 struct Brick {
     b2BodyId bodyId;
     b2ShapeId shapeId;
+    b2Vec2 position; // Bricks are static, so this never changes
     Color color;
+    Color emissive;
     bool destroyed;
     int hitPoints;
+    Destructible destructible;
+};
+
+// One pooled debris body. Inactive pieces are disabled, which takes them out
+// of the broadphase and the solver entirely. The body's user data points back
+// at its piece so move events can refresh it.
+struct DebrisPiece {
+    b2BodyId bodyId;
+    b2Transform transform; // Cached from body move events
+    Color color;
+    float timeLeft;
+    bool active;
+    bool awake;
+};
+
+struct DebrisPool {
+    std::vector<DebrisPiece> pieces; // Never resized after creation, bodies point into it
+    std::vector<int> freeList;
+    int activeCount;
+    int awakeCount;
+};
+
+// Stage times of the last brick build, in ms
+struct BrickBuildTimings {
+    double prepareMs = 0.0;
+    double createMs = 0.0;
+};
+
+// Persistent threads for Box2D's solver tasks, one per Box2D worker
+struct Box2DTasks {
+    WorkerPool pool;
+    std::deque<WorkerPool::Group> groups; // Task handles, reused once none are outstanding
+    int nextGroup = 0;
+    int outstanding = 0;
+
+    explicit Box2DTasks(int workerCount) : pool(workerCount) {}
 };
 
 // Game state
@@ -60,6 +227,17 @@ struct GameState {
     b2BodyId ballId;
     b2BodyId wallIds[4]; // left, right, top, bottom
     std::vector<Brick> bricks;
+    BrickBuildTimings brickBuild;
+    DebrisPool debris;
+    std::vector<ExplosionDef> explosions; // Queued for the next step
+    const ExplosionDef* explodeAction = nullptr; // Fired by E instead of the default, from --explode
+    b2Vec2 paddlePos; // Cached from body move events
+    b2Vec2 ballPos;
+    int staticBodiesRemoved; // Static tree churn since the last rebuild
+    int workerCount; // Box2D workers; above 1 they run on a thread pool
+    std::unique_ptr<Box2DTasks> box2dTasks;
+    std::vector<b2ContactData> wallContacts; // Scratch for countContacts
+    DeterministicRandom random; // Seeded per session so replays launch the same way
     int score;
     int lives;
     bool gameOver;
@@ -79,10 +257,62 @@ Color getBrickColor(int row) {
     }
 }
 
-// Initialize the physics world
-b2WorldId createWorld() {
+// Only the top row, worth the most, glows
+Color getBrickEmissive(int row) {
+    return row == 0 ? (Color){ 255, 70, 50, 255 } : BLANK;
+}
+
+#ifdef LEVELFORGE_ALLOC_TRACKING
+// Route Box2D's allocator through the allocation tracker
+ALLOC_TRACKER_NOINLINE static void* trackedBox2DAlloc(unsigned int size, int alignment) {
+    return alloc_tracker::AllocateAligned(size, (size_t)alignment, "box2d");
+}
+
+ALLOC_TRACKER_NOINLINE static void trackedBox2DFree(void* mem) {
+    alloc_tracker::Free(mem);
+}
+#endif
+
+// Box2D task callbacks. Each task's range is split into at most one chunk per
+// worker, at least minRange items each, and queued on the persistent pool;
+// finishTask waits for its chunks. The main thread only waits.
+void* enqueueBox2DTask(b2TaskCallback* task, int itemCount, int minRange, void* taskContext, void* userContext) {
+    Box2DTasks& tasks = *(Box2DTasks*)userContext;
+    int chunkCount = std::min(tasks.pool.GetWorkerCount(), std::max(1, itemCount / std::max(1, minRange)));
+    int chunk = std::max(1, (itemCount + chunkCount - 1) / chunkCount);
+
+    if (tasks.nextGroup == (int)tasks.groups.size()) tasks.groups.emplace_back();
+    WorkerPool::Group& group = tasks.groups[tasks.nextGroup++];
+    tasks.outstanding++;
+    for (int begin = 0; begin < itemCount; begin += chunk) {
+        int end = std::min(itemCount, begin + chunk);
+        tasks.pool.Submit(group, [task, begin, end, taskContext](int worker) {
+            task(begin, end, (uint32_t)worker, taskContext);
+        });
+    }
+    return &group;
+}
+
+void finishBox2DTask(void* userTask, void* userContext) {
+    Box2DTasks& tasks = *(Box2DTasks*)userContext;
+    tasks.pool.Wait(*(WorkerPool::Group*)userTask);
+    if (--tasks.outstanding == 0) tasks.nextGroup = 0; // Every handle is free again
+}
+
+// Initialize the physics world. Box2D gives the same result for any worker
+// count, which the determinism check relies on.
+b2WorldId createWorld(GameState& game) {
     b2WorldDef worldDef = b2DefaultWorldDef();
     worldDef.gravity = (b2Vec2){0.0f, 0.0f}; // No gravity for Breakout
+    if (game.workerCount > 1) {
+        if (game.box2dTasks == nullptr || game.box2dTasks->pool.GetWorkerCount() != game.workerCount) {
+            game.box2dTasks = std::make_unique<Box2DTasks>(game.workerCount);
+        }
+        worldDef.workerCount = game.workerCount;
+        worldDef.enqueueTask = enqueueBox2DTask;
+        worldDef.finishTask = finishBox2DTask;
+        worldDef.userTaskContext = game.box2dTasks.get();
+    }
     return b2CreateWorld(&worldDef);
 }
 
@@ -91,6 +321,7 @@ void createWalls(GameState& game) {
     b2ShapeDef shapeDef = b2DefaultShapeDef();
     shapeDef.material.friction = 0.0f;
     shapeDef.material.restitution = 1.0f; // Perfect bounce
+    shapeDef.filter.categoryBits = CATEGORY_WALL;
 
     float wallThickness = 0.5f;
 
@@ -172,51 +403,225 @@ b2BodyId createBall(b2WorldId worldId, float x, float y) {
     return ballId;
 }
 
-// Create all bricks
-void createBricks(GameState& game) {
+// Brick definition prepared ahead of body creation
+struct BrickDef {
+    b2BodyDef bodyDef;
+    b2Polygon box;
+    int row;
+};
+
+// Create all bricks. Defs are prepared in parallel; Box2D body creation is
+// not thread safe, so the bodies themselves are created serially.
+BrickBuildTimings createBricks(GameState& game) {
     float totalWidth = BRICK_COLS * (BRICK_WIDTH + BRICK_SPACING) - BRICK_SPACING;
     float startX = (WORLD_WIDTH - totalWidth) / 2.0f + BRICK_WIDTH / 2.0f;
+    int brickCount = BRICK_ROWS * BRICK_COLS;
+    BrickBuildTimings timings;
+    StageTimer timer;
+
+    std::vector<BrickDef> defs(brickCount);
+    ParallelFor(brickCount, 256, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            int row = i / BRICK_COLS;
+            int col = i % BRICK_COLS;
+            float x = startX + col * (BRICK_WIDTH + BRICK_SPACING);
+            float y = BRICK_START_Y - row * (BRICK_HEIGHT + BRICK_SPACING);
+
+            defs[i].bodyDef = b2DefaultBodyDef();
+            defs[i].bodyDef.position = (b2Vec2){x, y};
+            defs[i].box = b2MakeBox(BRICK_WIDTH / 2.0f, BRICK_HEIGHT / 2.0f);
+            defs[i].row = row;
+        }
+    });
+    timings.prepareMs = timer.Lap();
 
     b2ShapeDef shapeDef = b2DefaultShapeDef();
     shapeDef.material.friction = 0.0f;
     shapeDef.material.restitution = 1.0f;
     shapeDef.enableContactEvents = true;
 
-    for (int row = 0; row < BRICK_ROWS; row++) {
-        for (int col = 0; col < BRICK_COLS; col++) {
-            float x = startX + col * (BRICK_WIDTH + BRICK_SPACING);
-            float y = BRICK_START_Y - row * (BRICK_HEIGHT + BRICK_SPACING);
+    game.bricks.reserve(game.bricks.size() + brickCount);
+    for (const BrickDef& def : defs) {
+        b2BodyId brickBodyId = b2CreateBody(game.worldId, &def.bodyDef);
+        b2ShapeId brickShapeId = b2CreatePolygonShape(brickBodyId, &shapeDef, &def.box);
+
+        Brick brick;
+        brick.bodyId = brickBodyId;
+        brick.shapeId = brickShapeId;
+        brick.position = def.bodyDef.position;
+        brick.color = getBrickColor(def.row);
+        brick.emissive = getBrickEmissive(def.row);
+        brick.destroyed = false;
+        brick.hitPoints = (BRICK_ROWS - def.row); // Top rows worth more
+        brick.destructible = BRICK_DESTRUCTIBLE;
+
+        game.bricks.push_back(brick);
+    }
+    timings.createMs = timer.Lap();
+    return timings;
+}
 
-            b2BodyDef bodyDef = b2DefaultBodyDef();
-            bodyDef.position = (b2Vec2){x, y};
-            b2BodyId brickBodyId = b2CreateBody(game.worldId, &bodyDef);
+// Create the debris pool up front. Every piece starts disabled and is only
+// enabled while it is flying.
+void createDebrisPool(GameState& game) {
+    DebrisPool& pool = game.debris;
+    pool.pieces.clear();
+    pool.freeList.clear();
+    pool.activeCount = 0;
+    pool.awakeCount = 0;
 
-            b2Polygon box = b2MakeBox(BRICK_WIDTH / 2.0f, BRICK_HEIGHT / 2.0f);
-            b2ShapeId brickShapeId = b2CreatePolygonShape(brickBodyId, &shapeDef, &box);
+    b2BodyDef bodyDef = b2DefaultBodyDef();
+    bodyDef.type = b2_dynamicBody;
+    bodyDef.position = (b2Vec2){-DEBRIS_CULL_MARGIN * 2.0f, -DEBRIS_CULL_MARGIN * 2.0f};
+    bodyDef.linearDamping = 1.5f;
+    bodyDef.angularDamping = 1.0f;
+    bodyDef.sleepThreshold = 0.5f; // Sleep well before the default 5 cm/s
+    bodyDef.isEnabled = false;
 
-            Brick brick;
-            brick.bodyId = brickBodyId;
-            brick.shapeId = brickShapeId;
-            brick.color = getBrickColor(row);
-            brick.destroyed = false;
-            brick.hitPoints = (BRICK_ROWS - row); // Top rows worth more
+    b2ShapeDef shapeDef = b2DefaultShapeDef();
+    shapeDef.density = 0.5f;
+    shapeDef.material.friction = 0.3f;
+    shapeDef.material.restitution = 0.4f;
+    shapeDef.filter.categoryBits = CATEGORY_DEBRIS;
+    shapeDef.filter.maskBits = CATEGORY_WALL;
+
+    b2Polygon box = b2MakeBox(BRICK_WIDTH / DEBRIS_COLUMNS / 2.0f, BRICK_HEIGHT / DEBRIS_ROWS / 2.0f);
+
+    pool.pieces.resize(DEBRIS_POOL_SIZE);
+    pool.freeList.reserve(DEBRIS_POOL_SIZE);
+    for (int i = DEBRIS_POOL_SIZE - 1; i >= 0; i--) {
+        DebrisPiece& piece = pool.pieces[i];
+        piece.bodyId = b2CreateBody(game.worldId, &bodyDef);
+        b2CreatePolygonShape(piece.bodyId, &shapeDef, &box);
+        b2Body_SetUserData(piece.bodyId, &piece);
+        piece.transform = b2Body_GetTransform(piece.bodyId);
+        piece.color = WHITE;
+        piece.timeLeft = 0.0f;
+        piece.active = false;
+        piece.awake = false;
+        pool.freeList.push_back(i);
+    }
+}
 
-            game.bricks.push_back(brick);
+void releaseDebris(DebrisPool& pool, int index) {
+    DebrisPiece& piece = pool.pieces[index];
+    if (!piece.active) return;
+    b2Body_Disable(piece.bodyId);
+    if (piece.awake) pool.awakeCount--;
+    piece.active = false;
+    piece.awake = false;
+    pool.freeList.push_back(index);
+    pool.activeCount--;
+}
+
+// Take a piece from the pool. When it is empty the piece closest to expiring
+// is recycled, so heavy destruction degrades to shorter-lived debris instead
+// of growing the world.
+int acquireDebris(DebrisPool& pool) {
+    if (pool.freeList.empty()) {
+        int oldest = -1;
+        for (int i = 0; i < (int)pool.pieces.size(); i++) {
+            if (pool.pieces[i].active && (oldest < 0 || pool.pieces[i].timeLeft < pool.pieces[oldest].timeLeft)) {
+                oldest = i;
+            }
+        }
+        if (oldest < 0) return -1;
+        releaseDebris(pool, oldest);
+    }
+
+    int index = pool.freeList.back();
+    pool.freeList.pop_back();
+    pool.activeCount++;
+    return index;
+}
+
+// Swap a broken entity for its pre-fractured pieces, sprayed away from the
+// impact point
+void shatter(GameState& game, const Destructible& destructible, b2Vec2 center, float width, float height,
+             b2Vec2 impact, Color color) {
+    float pieceWidth = width / destructible.columns;
+    float pieceHeight = height / destructible.rows;
+
+    for (int row = 0; row < destructible.rows; row++) {
+        for (int col = 0; col < destructible.columns; col++) {
+            int index = acquireDebris(game.debris);
+            if (index < 0) return;
+            DebrisPiece& piece = game.debris.pieces[index];
+
+            b2Vec2 position = {
+                center.x - width / 2.0f + (col + 0.5f) * pieceWidth,
+                center.y - height / 2.0f + (row + 0.5f) * pieceHeight
+            };
+            b2Vec2 away = b2Normalize(b2Sub(position, impact));
+            float speed = destructible.spraySpeed * (0.6f + 0.1f * game.random.Range(0, 8));
+            float spin = (float)game.random.Range(-10, 10);
+
+            b2Body_SetTransform(piece.bodyId, position, b2MakeRot(0.0f));
+            b2Body_Enable(piece.bodyId);
+            b2Body_SetLinearVelocity(piece.bodyId, b2MulSV(speed, away));
+            b2Body_SetAngularVelocity(piece.bodyId, spin);
+
+            piece.transform = b2Body_GetTransform(piece.bodyId);
+            piece.color = color;
+            piece.timeLeft = destructible.lifetime;
+            piece.active = true;
+            piece.awake = true; // Enabling wakes it
+            game.debris.awakeCount++;
         }
     }
 }
 
+// Age active pieces and return expired or far-away ones to the pool. Their
+// transforms are already fresh from readMovedBodies.
+void updateDebris(GameState& game, float dt) {
+    DebrisPool& pool = game.debris;
+    if (pool.activeCount == 0) return;
+
+    for (int i = 0; i < (int)pool.pieces.size(); i++) {
+        DebrisPiece& piece = pool.pieces[i];
+        if (!piece.active) continue;
+
+        piece.timeLeft -= dt;
+        b2Vec2 p = piece.transform.p;
+        bool outside = p.x < -DEBRIS_CULL_MARGIN || p.x > WORLD_WIDTH + DEBRIS_CULL_MARGIN ||
+                       p.y < -DEBRIS_CULL_MARGIN || p.y > WORLD_HEIGHT + DEBRIS_CULL_MARGIN;
+        if (piece.timeLeft <= 0.0f || outside) {
+            releaseDebris(pool, i);
+        }
+    }
+}
+
+// Rebuild the static tree once enough static bodies have been destroyed.
+// Only call this at quiet points (level load, between lives).
+void maintainStaticTree(GameState& game, bool force) {
+    const int minRemovedBeforeRebuild = 8;
+    if (!force && game.staticBodiesRemoved < minRemovedBeforeRebuild) return;
+
+    int heightBefore = b2World_GetCounters(game.worldId).staticTreeHeight;
+    b2World_RebuildStaticTree(game.worldId);
+    int heightAfter = b2World_GetCounters(game.worldId).staticTreeHeight;
+
+    TraceLog(LOG_INFO, "Static tree rebuilt after %d removals: height %d -> %d",
+        game.staticBodiesRemoved, heightBefore, heightAfter);
+    game.staticBodiesRemoved = 0;
+}
+
 // Initialize game state
 void initGame(GameState& game) {
-    game.worldId = createWorld();
+    game.worldId = createWorld(game);
     createWalls(game);
     game.paddleId = createPaddle(game.worldId);
 
     // Ball starts on top of paddle
-    b2Vec2 paddlePos = b2Body_GetPosition(game.paddleId);
-    game.ballId = createBall(game.worldId, paddlePos.x, paddlePos.y + PADDLE_HEIGHT / 2.0f + BALL_RADIUS + 0.1f);
+    game.paddlePos = b2Body_GetPosition(game.paddleId);
+    game.ballPos = (b2Vec2){game.paddlePos.x, game.paddlePos.y + PADDLE_HEIGHT / 2.0f + BALL_RADIUS + 0.1f};
+    game.ballId = createBall(game.worldId, game.ballPos.x, game.ballPos.y);
 
-    createBricks(game);
+    game.brickBuild = createBricks(game);
+    createDebrisPool(game);
+
+    game.staticBodiesRemoved = 0;
+    maintainStaticTree(game, true);
 
     game.score = 0;
     game.lives = 3;
@@ -225,12 +630,15 @@ void initGame(GameState& game) {
     game.ballLaunched = false;
 }
 
+// Place the ball on top of the paddle
+void placeBallOnPaddle(GameState& game) {
+    game.ballPos = (b2Vec2){game.paddlePos.x, game.paddlePos.y + PADDLE_HEIGHT / 2.0f + BALL_RADIUS + 0.1f};
+    b2Body_SetTransform(game.ballId, game.ballPos, b2MakeRot(0.0f));
+}
+
 // Reset ball to paddle
 void resetBall(GameState& game) {
-    b2Vec2 paddlePos = b2Body_GetPosition(game.paddleId);
-    b2Body_SetTransform(game.ballId,
-        (b2Vec2){paddlePos.x, paddlePos.y + PADDLE_HEIGHT / 2.0f + BALL_RADIUS + 0.1f},
-        b2MakeRot(0.0f));
+    placeBallOnPaddle(game);
     b2Body_SetLinearVelocity(game.ballId, (b2Vec2){0.0f, 0.0f});
     game.ballLaunched = false;
 }
@@ -239,7 +647,7 @@ void resetBall(GameState& game) {
 void launchBall(GameState& game) {
     if (!game.ballLaunched) {
         // Launch at an angle
-        float angle = ((float)GetRandomValue(-30, 30)) * DEG2RAD;
+        float angle = ((float)game.random.Range(-30, 30)) * DEG2RAD;
         float vx = BALL_INITIAL_SPEED * sinf(angle);
         float vy = BALL_INITIAL_SPEED * cosf(angle);
         b2Body_SetLinearVelocity(game.ballId, (b2Vec2){vx, vy});
@@ -247,7 +655,7 @@ void launchBall(GameState& game) {
     }
 }
 
-// Check if a brick was hit and destroy it
+// Check if a brick was hit and break it into debris
 void checkBrickCollisions(GameState& game) {
     b2ContactEvents contactEvents = b2World_GetContactEvents(game.worldId);
 
@@ -261,19 +669,48 @@ void checkBrickCollisions(GameState& game) {
             b2ShapeId brickShapeId = brick.shapeId;
             if (B2_ID_EQUALS(event->shapeIdA, brickShapeId) ||
                 B2_ID_EQUALS(event->shapeIdB, brickShapeId)) {
+                static MetricCounter& bricksDestroyed = MetricsRegistry::Get().GetCounter("bricks_destroyed");
+                bricksDestroyed.Add();
                 brick.destroyed = true;
                 game.score += brick.hitPoints * 10;
+                shatter(game, brick.destructible, brick.position, BRICK_WIDTH, BRICK_HEIGHT, game.ballPos, brick.color);
                 b2DestroyBody(brick.bodyId);
+                game.staticBodiesRemoved++;
                 break;
             }
         }
     }
 }
 
+// Refresh cached positions from Box2D's move events. Only bodies that moved
+// during the step are reported, so sleeping and static bodies cost nothing.
+void readMovedBodies(GameState& game) {
+    b2BodyEvents bodyEvents = b2World_GetBodyEvents(game.worldId);
+
+    for (int i = 0; i < bodyEvents.moveCount; i++) {
+        const b2BodyMoveEvent* event = &bodyEvents.moveEvents[i];
+
+        if (B2_ID_EQUALS(event->bodyId, game.ballId)) {
+            game.ballPos = event->transform.p;
+        } else if (B2_ID_EQUALS(event->bodyId, game.paddleId)) {
+            game.paddlePos = event->transform.p;
+        } else if (event->userData != nullptr) {
+            // Only debris bodies carry user data
+            DebrisPiece* piece = (DebrisPiece*)event->userData;
+            if (!piece->active) continue;
+            piece->transform = event->transform;
+            bool awake = !event->fellAsleep;
+            if (piece->awake != awake) {
+                piece->awake = awake;
+                game.debris.awakeCount += awake ? 1 : -1;
+            }
+        }
+    }
+}
+
 // Check for ball going out of bounds
 bool checkBallLost(GameState& game) {
-    b2Vec2 ballPos = b2Body_GetPosition(game.ballId);
-    return ballPos.y < 0.0f;
+    return game.ballPos.y < 0.0f;
 }
 
 // Check win condition
@@ -284,6 +721,49 @@ bool checkWin(GameState& game) {
     return true;
 }
 
+// Attribute touching contacts to both entities involved. The ball and the
+// debris are the only dynamic bodies, and debris only collides with the walls,
+// so the ball's contacts plus the walls' debris contacts are all of them.
+void countContacts(GameState& game, EntityCostTable& costs) {
+    b2ContactData contacts[16];
+    int count = b2Body_GetContactData(game.ballId, contacts, 16);
+
+    for (int i = 0; i < count; i++) {
+        if (contacts[i].manifold.pointCount == 0) continue;
+
+        b2BodyId bodyA = b2Shape_GetBody(contacts[i].shapeIdA);
+        b2BodyId other = B2_ID_EQUALS(bodyA, game.ballId) ? b2Shape_GetBody(contacts[i].shapeIdB) : bodyA;
+
+        int otherType = ENTITY_BRICK;
+        if (B2_ID_EQUALS(other, game.paddleId)) {
+            otherType = ENTITY_PADDLE;
+        } else {
+            for (int wall = 0; wall < 4; wall++) {
+                if (B2_ID_EQUALS(other, game.wallIds[wall])) otherType = ENTITY_WALL;
+            }
+        }
+
+        costs.AddContact(ENTITY_BALL);
+        costs.AddContact(otherType);
+    }
+
+    if (game.debris.activeCount == 0) return;
+    for (int wall = 0; wall < 4; wall++) {
+        game.wallContacts.resize(b2Body_GetContactCapacity(game.wallIds[wall]));
+        int wallCount = b2Body_GetContactData(game.wallIds[wall], game.wallContacts.data(), (int)game.wallContacts.size());
+        for (int i = 0; i < wallCount; i++) {
+            const b2ContactData& contact = game.wallContacts[i];
+            if (contact.manifold.pointCount == 0) continue;
+            // Ball contacts were counted above
+            if (B2_ID_EQUALS(b2Shape_GetBody(contact.shapeIdA), game.ballId) ||
+                B2_ID_EQUALS(b2Shape_GetBody(contact.shapeIdB), game.ballId)) continue;
+
+            costs.AddContact(ENTITY_DEBRIS);
+            costs.AddContact(ENTITY_WALL);
+        }
+    }
+}
+
 // Ensure ball maintains constant speed
 void maintainBallSpeed(GameState& game) {
     if (!game.ballLaunched) return;
@@ -307,10 +787,54 @@ void maintainBallSpeed(GameState& game) {
     }
 }
 
+void queueExplosion(GameState& game, const ExplosionDef& def) {
+    if (def.radius > 0.0f && def.impulse != 0.0f) game.explosions.push_back(def);
+}
+
+// Hand queued explosions to Box2D. It only falls off linearly, so other curves
+// go in as a few stacked linear explosions.
+void applyExplosions(GameState& game) {
+    for (const ExplosionDef& def : game.explosions) {
+        b2ExplosionDef explosion = b2DefaultExplosionDef();
+        explosion.position = (b2Vec2){def.x, def.y};
+
+        std::vector<ExplosionRamp> ramps = ExplosionRamps(def.falloff, def.radius);
+        if (ramps.empty()) {
+            explosion.radius = def.radius;
+            explosion.falloff = 0.0f;
+            explosion.impulsePerLength = def.impulse;
+            b2World_Explode(game.worldId, &explosion);
+            continue;
+        }
+        for (const ExplosionRamp& ramp : ramps) {
+            if (ramp.weight <= 0.0f) continue;
+            explosion.radius = 0.0f;
+            explosion.falloff = ramp.radius;
+            explosion.impulsePerLength = def.impulse * ramp.weight;
+            b2World_Explode(game.worldId, &explosion);
+        }
+    }
+    FrameProfiler::Get().SetCounter("explosions", (double)game.explosions.size());
+    game.explosions.clear();
+}
+
+uint32_t readButtons() {
+    uint32_t buttons = 0;
+    if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A)) buttons |= BUTTON_LEFT;
+    if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) buttons |= BUTTON_RIGHT;
+    if (IsKeyPressed(KEY_SPACE)) buttons |= BUTTON_LAUNCH;
+    if (IsKeyPressed(KEY_R)) buttons |= BUTTON_RESTART;
+    if (IsKeyPressed(KEY_E)) buttons |= BUTTON_EXPLODE;
+    return buttons;
+}
+
 // Update game logic
-void updateGame(GameState& game, float dt) {
+void updateGame(GameState& game, EntityCostTable& costs, uint32_t buttons, float dt) {
+    ProfileZone zone("Update");
+    StageTimer costTimer;
+
     if (game.gameOver || game.gameWon) {
-        if (IsKeyPressed(KEY_R)) {
+        if (buttons & BUTTON_RESTART) {
             // Cleanup and restart
             b2DestroyWorld(game.worldId);
             game.bricks.clear();
@@ -320,13 +844,13 @@ void updateGame(GameState& game, float dt) {
     }
 
     // Paddle movement
-    b2Vec2 paddlePos = b2Body_GetPosition(game.paddleId);
+    b2Vec2 paddlePos = game.paddlePos;
     float paddleVelX = 0.0f;
 
-    if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A)) {
+    if (buttons & BUTTON_LEFT) {
         paddleVelX = -PADDLE_SPEED;
     }
-    if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) {
+    if (buttons & BUTTON_RIGHT) {
         paddleVelX = PADDLE_SPEED;
     }
 
@@ -338,160 +862,557 @@ void updateGame(GameState& game, float dt) {
     if (paddlePos.x >= maxX && paddleVelX > 0) paddleVelX = 0;
 
     b2Body_SetLinearVelocity(game.paddleId, (b2Vec2){paddleVelX, 0.0f});
+    costs.AddTime(ENTITY_PADDLE, CostPhase::Update, costTimer.Lap());
 
     // Ball follows paddle before launch
     if (!game.ballLaunched) {
-        b2Vec2 newPaddlePos = b2Body_GetPosition(game.paddleId);
-        b2Body_SetTransform(game.ballId,
-            (b2Vec2){newPaddlePos.x, newPaddlePos.y + PADDLE_HEIGHT / 2.0f + BALL_RADIUS + 0.1f},
-            b2MakeRot(0.0f));
+        placeBallOnPaddle(game);
 
-        if (IsKeyPressed(KEY_SPACE)) {
+        if (buttons & BUTTON_LAUNCH) {
             launchBall(game);
         }
     }
+    costs.AddTime(ENTITY_BALL, CostPhase::Update, costTimer.Lap());
+
+    // Detonate with E: the explode action if one was given, otherwise at the ball
+    if (buttons & BUTTON_EXPLODE) {
+        if (game.explodeAction != nullptr) {
+            queueExplosion(game, *game.explodeAction);
+        } else {
+            queueExplosion(game, { game.ballPos.x, game.ballPos.y, 0.0f, EXPLOSION_RADIUS, EXPLOSION_IMPULSE,
+                                   ExplosionFalloff::Quadratic });
+        }
+    }
 
     // Physics step
-    b2World_Step(game.worldId, dt, 4);
+    {
+        ProfileZone physicsZone("Physics");
+        applyExplosions(game);
+        b2World_Step(game.worldId, dt, 4);
+        double physicsMs = costTimer.Lap();
+        costs.AddPhysicsTime(physicsMs);
+        static MetricHistogram& physicsStepMs = MetricsRegistry::Get().GetHistogram("physics_step_ms");
+        physicsStepMs.Record(physicsMs);
+        readMovedBodies(game);
+    }
+
+    countContacts(game, costs);
+    if (b2Body_IsAwake(game.paddleId)) costs.AddActiveBodies(ENTITY_PADDLE);
+    if (b2Body_IsAwake(game.ballId)) costs.AddActiveBodies(ENTITY_BALL);
+
+    b2Counters counters = b2World_GetCounters(game.worldId);
+    FrameProfiler::Get().SetCounter("bodies", counters.bodyCount);
+    FrameProfiler::Get().SetCounter("contacts", counters.contactCount);
+    FrameProfiler::Get().SetCounter("awake_bodies", b2World_GetAwakeBodyCount(game.worldId));
+    static MetricGauge& bodyCount = MetricsRegistry::Get().GetGauge("bodies");
+    static MetricGauge& awakeBodyCount = MetricsRegistry::Get().GetGauge("active_bodies");
+    bodyCount.Set(counters.bodyCount);
+    awakeBodyCount.Set(b2World_GetAwakeBodyCount(game.worldId));
 
     // Check collisions
+    costTimer.Lap();
     checkBrickCollisions(game);
+    costs.AddTime(ENTITY_BRICK, CostPhase::Update, costTimer.Lap());
+
+    updateDebris(game, dt);
+    costs.AddActiveBodies(ENTITY_DEBRIS, game.debris.awakeCount);
+    FrameProfiler::Get().SetCounter("debris", game.debris.activeCount);
+    static MetricGauge& debrisCount = MetricsRegistry::Get().GetGauge("debris");
+    debrisCount.Set(game.debris.activeCount);
+    costs.AddTime(ENTITY_DEBRIS, CostPhase::Update, costTimer.Lap());
 
     // Maintain ball speed
     maintainBallSpeed(game);
 
     // Check if ball lost
     if (game.ballLaunched && checkBallLost(game)) {
+        static MetricCounter& ballsLost = MetricsRegistry::Get().GetCounter("balls_lost");
+        ballsLost.Add();
         game.lives--;
         if (game.lives <= 0) {
             game.gameOver = true;
         } else {
             resetBall(game);
+            maintainStaticTree(game, false);
         }
     }
+    costs.AddTime(ENTITY_BALL, CostPhase::Update, costTimer.Lap());
 
     // Check win condition
     if (checkWin(game)) {
         game.gameWon = true;
     }
+    costs.AddTime(ENTITY_BRICK, CostPhase::Update, costTimer.Lap());
 }
 
-// Render the game
-void renderGame(const GameState& game) {
-    BeginDrawing();
-    ClearBackground((Color){20, 20, 30, 255}); // Dark blue background
+// HUD, laid out at the original 800x600 and rescaled when the window resizes
+struct Hud {
+    UiLayout layout{ (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT };
+    int score, lives, launchPrompt;
+    int overlay, gameOverTitle, winTitle, finalScore, restartPrompt;
+    int controls;
+};
+
+void initHud(Hud& hud) {
+    UiLayout& ui = hud.layout;
+    const float midX = SCREEN_WIDTH / 2.0f, midY = SCREEN_HEIGHT / 2.0f;
+    hud.score = ui.AddText("", { 20, 20 }, 24, UiAnchor::Left, WHITE);
+    hud.lives = ui.AddText("", { SCREEN_WIDTH - 120, 20 }, 24, UiAnchor::Left, WHITE);
+    hud.launchPrompt = ui.AddText("Press SPACE to launch", { midX, midY }, 20, UiAnchor::Center, YELLOW);
+
+    // Game over and win screens share the dimmed overlay and the text below the title
+    hud.overlay = ui.AddPanel({ 0, 0 }, { 1, 1 }, true, UiAnchor::Left, (Color){0, 0, 0, 180});
+    hud.gameOverTitle = ui.AddText("GAME OVER", { midX, midY - 50 }, 48, UiAnchor::Center, RED);
+    hud.winTitle = ui.AddText("YOU WIN!", { midX, midY - 50 }, 48, UiAnchor::Center, GREEN);
+    hud.finalScore = ui.AddText("", { midX, midY + 10 }, 24, UiAnchor::Center, WHITE);
+    hud.restartPrompt = ui.AddText("Press R to Restart", { midX, midY + 60 }, 20, UiAnchor::Center, YELLOW);
+
+    hud.controls = ui.AddText("A/D or Arrow Keys to Move   F2 - Entity costs   F3 - Follow camera   F4 - Bloom",
+        { 20, SCREEN_HEIGHT - 30 }, 16, UiAnchor::Left, GRAY);
+}
+
+// Refresh HUD text and visibility, then lay out only what changed
+void updateHud(Hud& hud, const GameState& game) {
+    UiLayout& ui = hud.layout;
+    ui.SetText(hud.score, TextFormat("SCORE: %d", game.score));
+    ui.SetText(hud.lives, TextFormat("LIVES: %d", game.lives));
+    ui.SetText(hud.finalScore, TextFormat("Final Score: %d", game.score));
+
+    bool ended = game.gameOver || game.gameWon;
+    ui.SetVisible(hud.launchPrompt, !game.ballLaunched && !ended);
+    ui.SetVisible(hud.overlay, ended);
+    ui.SetVisible(hud.gameOverTitle, game.gameOver);
+    ui.SetVisible(hud.winTitle, game.gameWon);
+    ui.SetVisible(hud.finalScore, ended);
+    ui.SetVisible(hud.restartPrompt, ended);
+
+    // Laid out in logical window units, which raylib already maps to the
+    // framebuffer on high-DPI displays, so no extra DPI scale here
+    ui.Update(GetScreenWidth(), GetScreenHeight(), 1.0f);
+    FrameProfiler::Get().SetCounter("ui_layouts", ui.GetLayoutCount());
+}
+
+// Draw the arena in world space, returns the bricks drawn
+int drawWorld(const GameState& game, const WorldCamera& camera, EntityCostTable& costs) {
+    StageTimer costTimer;
+    beginWorldMode(camera);
 
     // Draw walls (subtle)
-    DrawRectangle(0, 0, 10, SCREEN_HEIGHT, (Color){40, 40, 60, 255});
-    DrawRectangle(SCREEN_WIDTH - 10, 0, 10, SCREEN_HEIGHT, (Color){40, 40, 60, 255});
-    DrawRectangle(0, 0, SCREEN_WIDTH, 10, (Color){40, 40, 60, 255});
+    Color wallColor = (Color){40, 40, 60, 255};
+    DrawRectangleRec({ 0.0f, 0.0f, 10 * PIXEL, WORLD_HEIGHT }, wallColor);
+    DrawRectangleRec({ WORLD_WIDTH - 10 * PIXEL, 0.0f, 10 * PIXEL, WORLD_HEIGHT }, wallColor);
+    DrawRectangleRec({ 0.0f, WORLD_HEIGHT - 10 * PIXEL, WORLD_WIDTH, 10 * PIXEL }, wallColor);
+    costs.AddDraw(ENTITY_WALL, 3, 3 * RECT_TRIANGLES);
+    costs.AddTime(ENTITY_WALL, CostPhase::Render, costTimer.Lap());
 
     // Draw bricks
+    int bricksLeft = 0;
     for (const auto& brick : game.bricks) {
         if (brick.destroyed) continue;
-
-        b2Vec2 pos = b2Body_GetPosition(brick.bodyId);
-        float screenX = toScreenX(pos.x) - (BRICK_WIDTH / 2.0f) * SCALE;
-        float screenY = toScreenY(pos.y) - (BRICK_HEIGHT / 2.0f) * SCALE;
+        bricksLeft++;
 
         // Brick with border
-        DrawRectangle((int)screenX, (int)screenY,
-            (int)(BRICK_WIDTH * SCALE), (int)(BRICK_HEIGHT * SCALE), brick.color);
-        DrawRectangleLines((int)screenX, (int)screenY,
-            (int)(BRICK_WIDTH * SCALE), (int)(BRICK_HEIGHT * SCALE), WHITE);
+        Rectangle rect = worldRect(brick.position, BRICK_WIDTH, BRICK_HEIGHT);
+        DrawRectangleRec(rect, brick.color);
+        DrawRectangleLinesEx(rect, PIXEL, WHITE);
+    }
+    costs.AddDraw(ENTITY_BRICK, 2 * bricksLeft, bricksLeft * RECT_TRIANGLES);
+    costs.AddTime(ENTITY_BRICK, CostPhase::Render, costTimer.Lap());
+
+    // Draw debris, fading out over its last moments
+    float pieceWidth = BRICK_WIDTH / DEBRIS_COLUMNS;
+    float pieceHeight = BRICK_HEIGHT / DEBRIS_ROWS;
+    for (const DebrisPiece& piece : game.debris.pieces) {
+        if (!piece.active) continue;
+
+        float fade = piece.timeLeft < 0.4f ? piece.timeLeft / 0.4f : 1.0f;
+        Rectangle rect = { piece.transform.p.x, piece.transform.p.y, pieceWidth, pieceHeight };
+        Vector2 origin = { pieceWidth / 2.0f, pieceHeight / 2.0f };
+        float degrees = b2Rot_GetAngle(piece.transform.q) * RAD2DEG;
+        DrawRectanglePro(rect, origin, degrees, Fade(piece.color, fade));
     }
+    costs.AddDraw(ENTITY_DEBRIS, game.debris.activeCount, game.debris.activeCount * RECT_TRIANGLES);
+    costs.AddTime(ENTITY_DEBRIS, CostPhase::Render, costTimer.Lap());
 
     // Draw paddle
-    b2Vec2 paddlePos = b2Body_GetPosition(game.paddleId);
-    float paddleScreenX = toScreenX(paddlePos.x) - (PADDLE_WIDTH / 2.0f) * SCALE;
-    float paddleScreenY = toScreenY(paddlePos.y) - (PADDLE_HEIGHT / 2.0f) * SCALE;
-    DrawRectangle((int)paddleScreenX, (int)paddleScreenY,
-        (int)(PADDLE_WIDTH * SCALE), (int)(PADDLE_HEIGHT * SCALE), WHITE);
-
-    // Draw paddle glow effect
-    DrawRectangle((int)paddleScreenX + 5, (int)paddleScreenY + 2,
-        (int)(PADDLE_WIDTH * SCALE) - 10, 4, (Color){200, 200, 255, 255});
+    Rectangle paddleRect = worldRect(game.paddlePos, PADDLE_WIDTH, PADDLE_HEIGHT);
+    DrawRectangleRec(paddleRect, WHITE);
+    costs.AddDraw(ENTITY_PADDLE, 1, RECT_TRIANGLES);
+    costs.AddTime(ENTITY_PADDLE, CostPhase::Render, costTimer.Lap());
 
     // Draw ball
-    b2Vec2 ballPos = b2Body_GetPosition(game.ballId);
-    float ballScreenX = toScreenX(ballPos.x);
-    float ballScreenY = toScreenY(ballPos.y);
-    DrawCircle((int)ballScreenX, (int)ballScreenY, BALL_RADIUS * SCALE, WHITE);
+    Vector2 ballPos = { game.ballPos.x, game.ballPos.y };
+    DrawCircleV(ballPos, BALL_RADIUS, WHITE);
+    costs.AddDraw(ENTITY_BALL, 1, CIRCLE_TRIANGLES);
+    costs.AddTime(ENTITY_BALL, CostPhase::Render, costTimer.Lap());
+    endWorldMode();
+    return bricksLeft;
+}
+
+// Draw the emissive colors of entities that glow, at the bloom's resolution.
+// Everything lands in one batch however many entities glow.
+void drawEmissive(const GameState& game, const WorldCamera& camera, float resolution) {
+    beginWorldMode(camera, resolution);
+    for (const auto& brick : game.bricks) {
+        if (brick.destroyed || brick.emissive.a == 0) continue;
+        DrawRectangleRec(worldRect(brick.position, BRICK_WIDTH, BRICK_HEIGHT), brick.emissive);
+    }
+    DrawRectangleRec(worldRect(game.paddlePos, PADDLE_WIDTH, PADDLE_HEIGHT), PADDLE_EMISSIVE);
+    DrawCircleV({ game.ballPos.x, game.ballPos.y }, BALL_RADIUS, BALL_EMISSIVE);
+    endWorldMode();
+}
+
+// Render the game through the render graph. The world goes to an offscreen
+// scene target; emissive colors go through the bloom passes. The composite
+// puts the scene on screen, adds the bloom and draws the HUD on top.
+void renderGame(const GameState& game, const WorldCamera& camera, const Hud& hud, EntityCostTable& costs, bool showCosts,
+                Bloom& bloom, bool bloomEnabled, RenderGraph& graph, FrameCapture& capture) {
+    ProfileZone zone("Render");
+
+    int screenWidth = GetScreenWidth();
+    int screenHeight = GetScreenHeight();
+    graph.BeginFrame(screenWidth, screenHeight);
+    int scene = graph.AddTarget("scene", 1.0f);
+
+    int bricksLeft = 0;
+    graph.AddPass("world", {}, scene, true, (Color){20, 20, 30, 255}, [&]() { // Dark blue background
+        bricksLeft = drawWorld(game, camera, costs);
+    });
+
+    // Only read by the composite when bloom is on, otherwise these passes are culled
+    const float emissiveResolution = 0.5f;
+    int emissive = graph.AddTarget("emissive", emissiveResolution);
+    graph.AddPass("emissive", {}, emissive, true, BLACK, [&]() {
+        drawEmissive(game, camera, emissiveResolution);
+    });
+    BloomTargets glow = bloom.AddPasses(graph, emissive);
+    bool useBloom = bloomEnabled && bloom.IsLoaded();
+
+    Rectangle screenRect = { 0.0f, 0.0f, (float)screenWidth, (float)screenHeight };
+    auto composite = [&]() {
+        DrawRenderTarget(graph.GetTexture(scene), screenRect, WHITE);
+        if (useBloom) {
+            Bloom::Composite(graph, glow.tight, screenRect, BLOOM_STRENGTH);
+            Bloom::Composite(graph, glow.wide, screenRect, BLOOM_STRENGTH);
+        }
+
+        // Draw UI from the cached layout
+        DrawUiLayout(hud.layout);
+
+        if (showCosts) {
+            DrawEntityCostOverlay(costs, 110, 56, 5);
+        }
+    };
+    if (useBloom) graph.AddPass("composite", { scene, glow.tight, glow.wide }, kRenderBackbuffer, false, BLANK, composite);
+    else graph.AddPass("composite", { scene }, kRenderBackbuffer, false, BLANK, composite);
+
+    BeginDrawing();
+    graph.Execute();
 
-    // Ball glow
-    DrawCircle((int)ballScreenX - 2, (int)ballScreenY - 2, BALL_RADIUS * SCALE * 0.4f,
-        (Color){255, 255, 200, 200});
+    costs.SetPopulation(ENTITY_PADDLE, 1, 1);
+    costs.SetPopulation(ENTITY_BALL, 1, 1);
+    costs.SetPopulation(ENTITY_BRICK, bricksLeft, bricksLeft);
+    costs.SetPopulation(ENTITY_WALL, 4, 4);
+    costs.SetPopulation(ENTITY_DEBRIS, game.debris.activeCount, DEBRIS_POOL_SIZE);
 
-    // Draw UI
-    DrawText(TextFormat("SCORE: %d", game.score), 20, 20, 24, WHITE);
-    DrawText(TextFormat("LIVES: %d", game.lives), SCREEN_WIDTH - 120, 20, 24, WHITE);
+    const RenderGraphStats& stats = graph.GetStats();
+    FrameProfiler::Get().SetCounter("render_target_mb", stats.bytes / (1024.0 * 1024.0));
+    FrameProfiler::Get().SetCounter("render_passes_culled", stats.culledPasses);
 
-    // Instructions
-    if (!game.ballLaunched && !game.gameOver && !game.gameWon) {
-        const char* text = "Press SPACE to launch";
-        int textWidth = MeasureText(text, 20);
-        DrawText(text, (SCREEN_WIDTH - textWidth) / 2, SCREEN_HEIGHT / 2, 20, YELLOW);
+    if (capture.IsRunning()) {
+        ProfileZone captureZone("Capture");
+        capture.Capture();
     }
+    EndDrawing();
+}
 
-    // Game over screen
-    if (game.gameOver) {
-        DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, (Color){0, 0, 0, 180});
+// Determinism harness
+// Trace IDs: 0 paddle, 1 ball, then the bricks, then the debris pool
+const uint64_t DEBRIS_HASH_ID = 2 + BRICK_ROWS * BRICK_COLS;
+
+// Hash the moving bodies' full state, which bricks are left and the active
+// debris
+void hashGame(const GameState& game, DeterminismTrace& trace) {
+    std::vector<BodyHash> bodies;
+    b2BodyId movingBodies[2] = { game.paddleId, game.ballId };
+    for (int i = 0; i < 2; i++) {
+        b2Transform transform = b2Body_GetTransform(movingBodies[i]);
+        b2Vec2 velocity = b2Body_GetLinearVelocity(movingBodies[i]);
+        float angularVelocity = b2Body_GetAngularVelocity(movingBodies[i]);
+
+        StateHasher hasher;
+        hasher.Add(transform.p.x);
+        hasher.Add(transform.p.y);
+        hasher.Add(transform.q.c);
+        hasher.Add(transform.q.s);
+        hasher.Add(velocity.x);
+        hasher.Add(velocity.y);
+        hasher.Add(angularVelocity);
+        bodies.push_back({ (uint64_t)i, hasher.Get() });
+    }
+    for (size_t i = 0; i < game.bricks.size(); i++) {
+        bodies.push_back({ 2 + (uint64_t)i, game.bricks[i].destroyed ? 1u : 0u });
+    }
+    for (size_t i = 0; i < game.debris.pieces.size(); i++) {
+        const DebrisPiece& piece = game.debris.pieces[i];
+        if (!piece.active) continue;
+        b2Transform transform = b2Body_GetTransform(piece.bodyId);
+        b2Vec2 velocity = b2Body_GetLinearVelocity(piece.bodyId);
+
+        StateHasher hasher;
+        hasher.Add(transform.p.x);
+        hasher.Add(transform.p.y);
+        hasher.Add(transform.q.c);
+        hasher.Add(transform.q.s);
+        hasher.Add(velocity.x);
+        hasher.Add(velocity.y);
+        hasher.Add(b2Body_GetAngularVelocity(piece.bodyId));
+        hasher.Add(piece.timeLeft);
+        bodies.push_back({ DEBRIS_HASH_ID + (uint64_t)i, hasher.Get() });
+    }
 
-        const char* gameOverText = "GAME OVER";
-        int textWidth = MeasureText(gameOverText, 48);
-        DrawText(gameOverText, (SCREEN_WIDTH - textWidth) / 2, SCREEN_HEIGHT / 2 - 50, 48, RED);
+    StateHasher state;
+    state.Add(game.score);
+    state.Add(game.lives);
+    state.Add(game.gameOver);
+    state.Add(game.gameWon);
+    state.Add(game.ballLaunched);
+    trace.RecordTick(std::move(bodies), state.Get());
+}
+
+std::string describeBody(uint64_t id) {
+    if (id == 0) return "paddle";
+    if (id == 1) return "ball";
+    if (id >= DEBRIS_HASH_ID) return "debris #" + std::to_string(id - DEBRIS_HASH_ID);
+    return "brick #" + std::to_string(id - 2);
+}
 
-        const char* scoreText = TextFormat("Final Score: %d", game.score);
-        textWidth = MeasureText(scoreText, 24);
-        DrawText(scoreText, (SCREEN_WIDTH - textWidth) / 2, SCREEN_HEIGHT / 2 + 10, 24, WHITE);
+// Replay a session headlessly with the given Box2D worker count
+void runSession(const Session& session, int workerCount, const ExplosionDef* explodeAction, DeterminismTrace& trace) {
+    EntityCostTable costs;
+    GameState game;
+    game.workerCount = workerCount;
+    game.explodeAction = explodeAction;
+    game.random.Seed(session.seed);
+    initGame(game);
 
-        const char* restartText = "Press R to Restart";
-        textWidth = MeasureText(restartText, 20);
-        DrawText(restartText, (SCREEN_WIDTH - textWidth) / 2, SCREEN_HEIGHT / 2 + 60, 20, YELLOW);
+    for (const SessionTick& tick : session.ticks) {
+        updateGame(game, costs, tick.buttons, tick.dt);
+        hashGame(game, trace);
     }
 
-    // Win screen
-    if (game.gameWon) {
-        DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, (Color){0, 0, 0, 180});
+    b2DestroyWorld(game.worldId);
+}
 
-        const char* winText = "YOU WIN!";
-        int textWidth = MeasureText(winText, 48);
-        DrawText(winText, (SCREEN_WIDTH - textWidth) / 2, SCREEN_HEIGHT / 2 - 50, 48, GREEN);
+// Replay the session once per worker count and compare every run against the
+// first, optionally saving or comparing a trace from another build
+int verifyDeterminism(const Session& session, const std::vector<int>& workerCounts, const ExplosionDef* explodeAction,
+                      const char* traceOutPath, const char* compareTracePath) {
+    TraceLog(LOG_INFO, "Verifying determinism over %d ticks", (int)session.ticks.size());
+
+    std::vector<DeterminismTrace> traces;
+    for (int workerCount : workerCounts) {
+        DeterminismTrace trace;
+        trace.label = std::to_string(workerCount) + (workerCount == 1 ? " worker" : " workers");
+        runSession(session, workerCount, explodeAction, trace);
+        traces.push_back(std::move(trace));
+    }
 
-        const char* scoreText = TextFormat("Final Score: %d", game.score);
-        textWidth = MeasureText(scoreText, 24);
-        DrawText(scoreText, (SCREEN_WIDTH - textWidth) / 2, SCREEN_HEIGHT / 2 + 10, 24, WHITE);
+    bool match = true;
+    for (size_t i = 1; i < traces.size(); i++) {
+        match &= ReportDeterminism(traces[0], traces[i], describeBody);
+    }
 
-        const char* restartText = "Press R to Restart";
-        textWidth = MeasureText(restartText, 20);
-        DrawText(restartText, (SCREEN_WIDTH - textWidth) / 2, SCREEN_HEIGHT / 2 + 60, 20, YELLOW);
+    if (traceOutPath != nullptr && !SaveTrace(traces[0], traceOutPath)) {
+        TraceLog(LOG_ERROR, "Failed to write trace %s", traceOutPath);
+        match = false;
     }
 
-    // Controls hint
-    DrawText("A/D or Arrow Keys to Move", 20, SCREEN_HEIGHT - 30, 16, GRAY);
+    if (compareTracePath != nullptr) {
+        DeterminismTrace other;
+        if (LoadTrace(compareTracePath, other)) {
+            match &= ReportDeterminism(other, traces[0], describeBody);
+        } else {
+            TraceLog(LOG_ERROR, "Failed to read trace %s", compareTracePath);
+            match = false;
+        }
+    }
 
-    EndDrawing();
+    TraceLog(LOG_INFO, match ? "Deterministic" : "NOT deterministic");
+    return match ? 0 : 1;
 }
 
-int main(void) {
+int main(int argc, char** argv) {
+    // Command line, same as the 3D demo:
+    //   --record <session>              record inputs while playing
+    //   --verify-determinism [session]  replay headless (a scripted session if none is given)
+    //   --threads <n,n,...>             Box2D worker counts to compare (default 1,2,4,8)
+    //   --ticks <n>                     length of the scripted session (default 3600)
+    //   --trace-out <file>              save the hash trace for comparing builds
+    //   --compare-trace <file>          compare against a trace saved by another build
+    //   --capture <file>                record the window (.y4m video, otherwise numbered PNGs)
+    //   --explode <x>,<y>,<radius>,<impulse>[,<falloff>]
+    //                                   explode action fired by E, in place of the blast at the
+    //                                   ball; pass it again when replaying a session recorded with it
+    const char* recordPath = nullptr;
+    const char* capturePath = nullptr;
+    const char* sessionPath = nullptr;
+    const char* traceOutPath = nullptr;
+    const char* compareTracePath = nullptr;
+    bool verify = false;
+    std::vector<int> workerCounts = { 1, 2, 4, 8 };
+    int scriptedTicks = 3600;
+    ExplosionDef explodeActionDef;
+    const ExplosionDef* explodeAction = nullptr;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc && argv[i + 1][0] != '-';
+        if (strcmp(argv[i], "--record") == 0 && hasValue) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--explode") == 0 && i + 1 < argc) {
+            // Coordinates may be negative, so the value can start with '-'
+            if (!ParseExplodeAction(argv[++i], false, explodeActionDef)) {
+                TraceLog(LOG_ERROR, "Bad explode action: %s", argv[i]);
+                return 2;
+            }
+            explodeAction = &explodeActionDef;
+        }
+        else if (strcmp(argv[i], "--capture") == 0 && hasValue) capturePath = argv[++i];
+        else if (strcmp(argv[i], "--verify-determinism") == 0) {
+            verify = true;
+            if (hasValue) sessionPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue) workerCounts = ParseThreadCounts(argv[++i]);
+        else if (strcmp(argv[i], "--ticks") == 0 && hasValue) scriptedTicks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--trace-out") == 0 && hasValue) traceOutPath = argv[++i];
+        else if (strcmp(argv[i], "--compare-trace") == 0 && hasValue) compareTracePath = argv[++i];
+        else {
+            TraceLog(LOG_ERROR, "Unknown argument: %s", argv[i]);
+            return 2;
+        }
+    }
+
+    // Soak test metrics, if LEVELFORGE_METRICS is set. Started before the
+    // headless modes so soak runs export too, and flushed on every return.
+    ScopedMetrics metrics;
+
+    // Box2D's allocator has to be set before the first world is created
+    InstallAllocTracker();
+#ifdef LEVELFORGE_ALLOC_TRACKING
+    b2SetAllocator(trackedBox2DAlloc, trackedBox2DFree);
+#endif
+
+    if (verify) {
+        Session session;
+        if (sessionPath == nullptr) {
+            session = MakeScriptedSession(1234, scriptedTicks, 1.0f / 60.0f, BUTTON_LEFT | BUTTON_RIGHT, BUTTON_LAUNCH | BUTTON_RESTART | BUTTON_EXPLODE);
+        } else if (!LoadSession(sessionPath, session)) {
+            TraceLog(LOG_ERROR, "Failed to read session %s", sessionPath);
+            return 2;
+        }
+        if (workerCounts.empty()) workerCounts.push_back(1);
+        return verifyDeterminism(session, workerCounts, explodeAction, traceOutPath, compareTracePath);
+    }
+
     // Initialize raylib
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Breakout - raylib + Box2D Demo");
     SetTargetFPS(60);
 
+    // Every session is recorded in memory and saved on exit with --record
+    Session session;
+    session.seed = (uint64_t)time(nullptr);
+
     // Initialize game
     GameState game;
+    game.workerCount = 1;
+    game.explodeAction = explodeAction;
+    game.random.Seed(session.seed);
     initGame(game);
+    TraceLog(LOG_INFO, "Built %d bricks: prepare %.3f ms, create %.3f ms",
+             (int)game.bricks.size(), game.brickBuild.prepareMs, game.brickBuild.createMs);
+
+    // Dump a trace of the last few seconds whenever a frame takes over 50 ms
+    ConfigureHitchRecorder(60, 50.0);
+#ifdef LEVELFORGE_ALLOC_TRACKING
+    uint64_t lastAllocCount = GetAllocStats().allocCount;
+#endif
+
+    // Cost attribution per entity type, in EntityType order
+    EntityCostTable costs;
+    costs.AddType("paddle");
+    costs.AddType("ball");
+    costs.AddType("brick");
+    costs.AddType("wall");
+    costs.AddType("debris");
+    bool showCosts = false;
+
+    // Fixed on the whole arena; F3 zooms in and follows the ball
+    WorldCamera camera = makeArenaCamera();
+    bool followBall = false;
+
+    Hud hud;
+    initHud(hud);
+
+    RenderGraph graph;
+    Bloom bloom;
+    bloom.Load();
+    bool bloomEnabled = true;
+    FrameCapture capture;
+    if (capturePath != nullptr && !capture.Start(capturePath, 60)) {
+        TraceLog(LOG_ERROR, "Can't capture to %s", capturePath);
+    }
 
     // Main game loop
     while (!WindowShouldClose()) {
+        FrameProfiler::Get().BeginFrame();
+        costs.BeginFrame();
         float dt = GetFrameTime();
 
-        updateGame(game, dt);
-        renderGame(game);
+        if (IsKeyPressed(KEY_F2)) showCosts = !showCosts;
+        if (IsKeyPressed(KEY_F3)) followBall = !followBall;
+        if (IsKeyPressed(KEY_F4)) bloomEnabled = !bloomEnabled;
+
+        uint32_t buttons = readButtons();
+        if (recordPath != nullptr) session.ticks.push_back({ buttons, dt });
+        updateGame(game, costs, buttons, dt);
+        if (followBall) followCamera(camera, game.ballPos, 1.6f, dt);
+        else followCamera(camera, makeArenaCamera().center, 1.0f, dt);
+        updateHud(hud, game);
+        renderGame(game, camera, hud, costs, showCosts, bloom, bloomEnabled, graph, capture);
+        costs.EndFrame();
+
+#ifdef LEVELFORGE_ALLOC_TRACKING
+        AllocStats allocStats = GetAllocStats();
+        FrameProfiler::Get().SetCounter("allocs", (double)(allocStats.allocCount - lastAllocCount));
+        FrameProfiler::Get().SetCounter("tracked_live_bytes", (double)allocStats.liveBytes);
+        lastAllocCount = allocStats.allocCount;
+#endif
+        RecordFrameMetrics(dt);
+        FrameProfiler::Get().EndFrame();
+    }
+
+    // Report which entity types cost the most over the session
+    TraceLog(LOG_INFO, "%s", costs.FormatReport().c_str());
+    if (const char* reportPath = GetEntityReportPath()) {
+        if (costs.WriteReport(reportPath)) TraceLog(LOG_INFO, "Entity cost report written to %s", reportPath);
+    }
+
+    if (recordPath != nullptr && SaveSession(session, recordPath)) {
+        TraceLog(LOG_INFO, "Session recorded to %s", recordPath);
     }
+    capture.Stop();
+    TraceLog(LOG_INFO, "Render targets: peak %.2f MB, %.2f MB without aliasing", graph.GetPeakBytes() / (1024.0 * 1024.0),
+        graph.GetPeakUnaliasedBytes() / (1024.0 * 1024.0));
 
     // Cleanup
+    graph.Release(); // Both need the GL context
+    bloom.Unload();
     b2DestroyWorld(game.worldId);
+
+#ifdef LEVELFORGE_ALLOC_TRACKING
+    if (WriteAllocReport("alloc_report.json")) {
+        TraceLog(LOG_INFO, "Allocation report written to alloc_report.json");
+    }
+#endif
     CloseWindow();
 
     return 0;
@@ -3,13 +3,36 @@
 
 #include <iostream>
 #include <vector>
+#include <map>
 #include <cstdarg>
+#include <cstring>
 #include <thread>
+#include <mutex>
 #include <cmath>
+#include <cfloat>
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <tuple>
 
 // Raylib - include first and save Color type
 #include "raylib.h"
 #include "raymath.h"
+#include "rlgl.h"
+
+#include "alloc_tracker.h"
+#include "bench_results.h"
+#include "cutscene.h"
+#include "determinism.h"
+#include "entity_costs.h"
+#include "explosion.h"
+#include "force_fields.h"
+#include "frame_capture.h"
+#include "frame_profiler.h"
+#include "joint_defs.h"
+#include "metrics.h"
+#include "parallel_for.h"
 
 // Alias raylib's Color before Jolt pollutes the namespace
 typedef ::Color RayColor;
@@ -22,10 +45,24 @@ typedef ::Color RayColor;
 #include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/Physics/PhysicsSystem.h>
+#include <Jolt/Physics/StateRecorderImpl.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <Jolt/Physics/Collision/Shape/StaticCompoundShape.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
 #include <Jolt/Physics/Body/BodyActivationListener.h>
+#include <Jolt/Physics/Body/BodyLockMulti.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/GroupFilter.h>
+#include <Jolt/Physics/Constraints/PointConstraint.h>
+#include <Jolt/Physics/Constraints/HingeConstraint.h>
+#include <Jolt/Physics/Constraints/DistanceConstraint.h>
+#include <Jolt/Physics/Constraints/SliderConstraint.h>
+#include <Jolt/Physics/Constraints/FixedConstraint.h>
+#include <Jolt/Physics/SoftBody/SoftBodySharedSettings.h>
+#include <Jolt/Physics/SoftBody/SoftBodyCreationSettings.h>
+#include <Jolt/Physics/SoftBody/SoftBodyMotionProperties.h>
 
 JPH_SUPPRESS_WARNINGS
 
@@ -49,6 +86,22 @@ const float ARENA_WIDTH = 20.0f;
 const float ARENA_DEPTH = 30.0f;
 const int NUM_TARGETS = 5;
 
+// Chain strung across the arena in front of the targets
+const int CHAIN_LINKS = 40;
+const float CHAIN_LINK_RADIUS = 0.15f;
+const float CHAIN_HEIGHT = 6.0f;
+const float CHAIN_Z = -ARENA_DEPTH/4 + 2.0f;
+
+// Explosion triggered with E, centered on the ball unless --explode gives one
+const float EXPLOSION_RADIUS = 5.0f;
+const float EXPLOSION_IMPULSE = 12.0f;
+
+// Triangles raylib emits for the primitives drawn below (wires are lines)
+const int PLANE_TRIANGLES = 2;
+const int CUBE_TRIANGLES = 12;
+const int SPHERE_TRIANGLES = (16 + 2) * 16 * 2; // DrawSphere: 16 rings, 16 slices
+const int LINK_TRIANGLES = (6 + 2) * 6 * 2;     // DrawSphereEx: 6 rings, 6 slices
+
 // Raylib color constants (to avoid ambiguity with JPH::Color)
 const RayColor COLOR_BG         = { 40, 40, 50, 255 };
 const RayColor COLOR_FLOOR      = { 60, 100, 60, 255 };
@@ -66,6 +119,7 @@ const RayColor COLOR_ORANGE     = { 255, 161, 0, 255 };
 const RayColor COLOR_SKYBLUE    = { 102, 191, 255, 255 };
 const RayColor COLOR_DARKBLUE   = { 0, 82, 172, 255 };
 const RayColor COLOR_GRAY       = { 130, 130, 130, 255 };
+const RayColor COLOR_WATER      = { 40, 120, 220, 110 };
 
 // Trace callback for Jolt
 static void TraceImpl(const char *inFMT, ...) {
@@ -84,6 +138,32 @@ static bool AssertFailedImpl(const char *inExpression, const char *inMessage, co
 }
 #endif
 
+#ifdef LEVELFORGE_ALLOC_TRACKING
+// Route Jolt's allocator through the allocation tracker
+ALLOC_TRACKER_NOINLINE static void* TrackedJoltAllocate(size_t inSize) {
+    return alloc_tracker::Allocate(inSize, "jolt");
+}
+
+ALLOC_TRACKER_NOINLINE static void* TrackedJoltReallocate(void* inBlock, size_t inOldSize, size_t inNewSize) {
+    void* block = alloc_tracker::Allocate(inNewSize, "jolt");
+    if (block != nullptr && inBlock != nullptr) memcpy(block, inBlock, min(inOldSize, inNewSize));
+    alloc_tracker::Free(inBlock);
+    return block;
+}
+
+ALLOC_TRACKER_NOINLINE static void TrackedJoltFree(void* inBlock) {
+    alloc_tracker::Free(inBlock);
+}
+
+ALLOC_TRACKER_NOINLINE static void* TrackedJoltAlignedAllocate(size_t inSize, size_t inAlignment) {
+    return alloc_tracker::AllocateAligned(inSize, inAlignment, "jolt");
+}
+
+ALLOC_TRACKER_NOINLINE static void TrackedJoltAlignedFree(void* inBlock) {
+    alloc_tracker::Free(inBlock);
+}
+#endif
+
 // Collision layers
 namespace Layers {
     static constexpr ObjectLayer NON_MOVING = 0;
@@ -165,6 +245,48 @@ public:
     }
 };
 
+// Entity handles stored in each body's user data, so contact callbacks can
+// resolve the entity behind a Body in O(1) instead of searching game state
+enum class EntityType : uint32 {
+    None = 0,
+    Floor,
+    Wall,
+    Paddle,
+    Ball,
+    Target,
+    ChainLink,
+    SoftBody,
+    ForceField,   // No body; costs only
+    StaticRegion, // Merged static geometry, see StaticWorld
+};
+
+inline uint64 MakeEntityHandle(EntityType type, uint32 index) {
+    return ((uint64)type << 32) | index;
+}
+
+inline EntityType GetEntityType(uint64 handle) {
+    return (EntityType)(handle >> 32);
+}
+
+inline uint32 GetEntityIndex(uint64 handle) {
+    return (uint32)(handle & 0xffffffff);
+}
+
+const char* GetEntityTypeName(EntityType type) {
+    switch (type) {
+    case EntityType::Floor:        return "floor";
+    case EntityType::Wall:         return "wall";
+    case EntityType::Paddle:       return "paddle";
+    case EntityType::Ball:         return "ball";
+    case EntityType::Target:       return "target";
+    case EntityType::ChainLink:    return "chain_link";
+    case EntityType::SoftBody:     return "softbody";
+    case EntityType::ForceField:   return "force_field";
+    case EntityType::StaticRegion: return "static_region";
+    default:                       return "none";
+    }
+}
+
 // Target structure
 struct Target {
     BodyID bodyId;
@@ -180,11 +302,101 @@ struct GameState {
     int ballsRemaining = 10;
     bool ballInPlay = false;
     vector<Target> targets;
+    DeterministicRandom random; // Seeded per session so replays roll the same targets
+};
+
+// Static level geometry
+// Static pieces are merged into one StaticCompoundShape body per region, which
+// cuts body count and broadphase proxies. Each sub shape's user data indexes
+// its region's entity table, so contacts can still be traced to an entity.
+struct StaticPiece {
+    ShapeRefC shape;
+    RVec3 position;
+    uint64 entity;
+};
+
+struct StaticRegion {
+    BodyID bodyId;
+    vector<uint64> entities;
+};
+
+struct StaticWorld {
+    float regionSize = 64.0f;
+    vector<StaticRegion> regions;
 };
 
+void BuildStaticWorld(BodyInterface& bodyInterface, const vector<StaticPiece>& pieces, StaticWorld& world) {
+    // Bucket pieces into region cells centered on the origin
+    map<pair<int, int>, vector<size_t>> cells;
+    for (size_t i = 0; i < pieces.size(); i++) {
+        int cellX = (int)floorf(((float)pieces[i].position.GetX() + world.regionSize/2) / world.regionSize);
+        int cellZ = (int)floorf(((float)pieces[i].position.GetZ() + world.regionSize/2) / world.regionSize);
+        cells[{ cellX, cellZ }].push_back(i);
+    }
+
+    size_t placed = 0;
+    for (const auto& cell : cells) {
+        StaticRegion region;
+        RVec3 origin(cell.first.first * world.regionSize, 0.0_r, cell.first.second * world.regionSize);
+
+        // StaticCompoundShape needs at least two sub shapes; a lone piece
+        // becomes a plain static body in its region's place
+        ShapeRefC regionShape;
+        RVec3 regionPosition = origin;
+        if (cell.second.size() == 1) {
+            const StaticPiece& piece = pieces[cell.second[0]];
+            regionShape = piece.shape;
+            regionPosition = piece.position;
+            region.entities.push_back(piece.entity);
+        } else {
+            StaticCompoundShapeSettings compoundSettings;
+            for (size_t index : cell.second) {
+                const StaticPiece& piece = pieces[index];
+                compoundSettings.AddShape(Vec3(piece.position - origin), Quat::sIdentity(), piece.shape, (uint32)region.entities.size());
+                region.entities.push_back(piece.entity);
+            }
+
+            ShapeSettings::ShapeResult result = compoundSettings.Create();
+            if (result.HasError()) {
+                cout << "Failed to build static region: " << result.GetError() << endl;
+                continue;
+            }
+            regionShape = result.Get();
+        }
+
+        BodyCreationSettings regionSettings(regionShape, regionPosition, Quat::sIdentity(), EMotionType::Static, Layers::NON_MOVING);
+        regionSettings.mUserData = MakeEntityHandle(EntityType::StaticRegion, (uint32)world.regions.size());
+        region.bodyId = bodyInterface.CreateAndAddBody(regionSettings, EActivation::DontActivate);
+        placed += region.entities.size();
+        world.regions.push_back(region);
+    }
+
+    // Every piece must have collision somewhere
+    if (placed != pieces.size()) {
+        cout << "Static world: " << pieces.size() - placed << " of " << pieces.size() << " pieces have no region body" << endl;
+    }
+    JPH_ASSERT(placed == pieces.size());
+}
+
 // Global for contact detection
 static GameState* gGameState = nullptr;
+static StaticWorld* gStaticWorld = nullptr;
 static BodyID gBallId;
+static EntityCostTable* gEntityCosts = nullptr;
+static const ExplosionDef* gExplodeAction = nullptr; // Fired by E instead of the default, from --explode
+
+// Resolve the entity a contact touched, looking through merged static regions
+uint64 ResolveEntity(const Body& body, const SubShapeID& subShapeId) {
+    uint64 handle = body.GetUserData();
+    if (GetEntityType(handle) != EntityType::StaticRegion || gStaticWorld == nullptr) return handle;
+
+    const StaticRegion& region = gStaticWorld->regions[GetEntityIndex(handle)];
+    if (region.entities.size() == 1) return region.entities[0]; // Lone piece, not a compound
+    const CompoundShape* compound = static_cast<const CompoundShape*>(body.GetShape());
+    SubShapeID remainder;
+    uint32 subShapeIndex = compound->GetSubShapeIndexFromID(subShapeId, remainder);
+    return region.entities[compound->GetCompoundUserData(subShapeIndex)];
+}
 
 // Contact listener for scoring
 class GameContactListener : public ContactListener {
@@ -196,45 +408,367 @@ public:
     virtual void OnContactAdded(const Body &inBody1, const Body &inBody2, const ContactManifold &inManifold, ContactSettings &ioSettings) override {
         if (gGameState == nullptr) return;
 
-        BodyID id1 = inBody1.GetID();
-        BodyID id2 = inBody2.GetID();
+        uint64 handle1 = ResolveEntity(inBody1, inManifold.mSubShapeID1);
+        uint64 handle2 = ResolveEntity(inBody2, inManifold.mSubShapeID2);
+        CountContact(handle1, handle2);
+        if (GetEntityType(handle2) == EntityType::Ball) swap(handle1, handle2);
 
-        // Check if ball hit a target
-        for (auto& target : gGameState->targets) {
-            if (!target.active) continue;
-            if ((id1 == gBallId && id2 == target.bodyId) || (id2 == gBallId && id1 == target.bodyId)) {
-                gGameState->score += target.points;
-                target.active = false;
-                cout << "Target hit! +" << target.points << " points. Total: " << gGameState->score << endl;
-                break;
-            }
-        }
+        // Check if ball hit a target. This runs on the physics threads, so
+        // hits are queued and scored on the main thread after the update.
+        if (GetEntityType(handle1) != EntityType::Ball || GetEntityType(handle2) != EntityType::Target) return;
+
+        lock_guard<mutex> lock(mHitMutex);
+        mHits.push_back(GetEntityIndex(handle2));
+    }
+
+    virtual void OnContactPersisted(const Body &inBody1, const Body &inBody2, const ContactManifold &inManifold, ContactSettings &ioSettings) override {
+        if (gEntityCosts == nullptr) return;
+        CountContact(ResolveEntity(inBody1, inManifold.mSubShapeID1), ResolveEntity(inBody2, inManifold.mSubShapeID2));
     }
 
-    virtual void OnContactPersisted(const Body &inBody1, const Body &inBody2, const ContactManifold &inManifold, ContactSettings &ioSettings) override {}
     virtual void OnContactRemoved(const SubShapeIDPair &inSubShapePair) override {}
+
+    // Move queued target hits into outHits
+    void TakeHits(vector<uint32>& outHits) {
+        lock_guard<mutex> lock(mHitMutex);
+        outHits.swap(mHits);
+        mHits.clear();
+    }
+
+private:
+    // Charge a touching pair to both entity types
+    static void CountContact(uint64 handle1, uint64 handle2) {
+        if (gEntityCosts == nullptr) return;
+        gEntityCosts->AddContact((int)GetEntityType(handle1));
+        gEntityCosts->AddContact((int)GetEntityType(handle2));
+    }
+
+    mutex mHitMutex;
+    vector<uint32> mHits;
 };
 
+// Score the targets hit during the last physics update. Sorting makes the
+// result independent of which physics thread reported each hit first.
+void ApplyTargetHits(GameContactListener& contactListener, GameState& gameState) {
+    vector<uint32> hits;
+    contactListener.TakeHits(hits);
+    sort(hits.begin(), hits.end());
+
+    for (uint32 index : hits) {
+        if (index >= gameState.targets.size()) continue;
+
+        Target& target = gameState.targets[index];
+        if (!target.active) continue;
+
+        static MetricCounter& targetsHit = MetricsRegistry::Get().GetCounter("targets_hit");
+        targetsHit.Add();
+
+        gameState.score += target.points;
+        target.active = false;
+    }
+}
+
 // Body activation listener
+// Called from the physics threads; remembers bodies that fell asleep so they
+// get one last readback of their resting transform
 class GameBodyActivationListener : public BodyActivationListener {
 public:
     virtual void OnBodyActivated(const BodyID &inBodyID, uint64 inBodyUserData) override {}
-    virtual void OnBodyDeactivated(const BodyID &inBodyID, uint64 inBodyUserData) override {}
+
+    virtual void OnBodyDeactivated(const BodyID &inBodyID, uint64 inBodyUserData) override {
+        lock_guard<mutex> lock(mMutex);
+        mDeactivated.push_back(inBodyID);
+    }
+
+    // Append bodies deactivated since the last call to outBodyIDs
+    void TakeDeactivated(BodyIDVector& outBodyIDs) {
+        lock_guard<mutex> lock(mMutex);
+        outBodyIDs.insert(outBodyIDs.end(), mDeactivated.begin(), mDeactivated.end());
+        mDeactivated.clear();
+    }
+
+private:
+    mutex mMutex;
+    BodyIDVector mDeactivated;
+};
+
+// Entity whose body moved during the last physics update
+struct MovingEntity {
+    BodyID bodyId;
+    uint64 entity;
+    RVec3 position;
+};
+
+// Per-frame set of moving entities, built from the active bodies plus any
+// that went to sleep this frame. Systems that only care about things that
+// move iterate this instead of every entity in the world.
+struct MovingSet {
+    BodyIDVector bodyIds;
+    vector<MovingEntity> entities;
+};
+
+void BuildMovingSet(PhysicsSystem& physicsSystem, GameBodyActivationListener& activationListener, MovingSet& movingSet) {
+    movingSet.bodyIds.clear();
+    movingSet.entities.clear();
+
+    physicsSystem.GetActiveBodies(EBodyType::RigidBody, movingSet.bodyIds);
+    activationListener.TakeDeactivated(movingSet.bodyIds);
+    if (movingSet.bodyIds.empty()) return;
+
+    // Read back user data and transforms under a single multi-body lock
+    BodyLockMultiRead lock(physicsSystem.GetBodyLockInterface(), movingSet.bodyIds.data(), (int)movingSet.bodyIds.size());
+    for (int i = 0; i < (int)movingSet.bodyIds.size(); i++) {
+        const Body* body = lock.GetBody(i);
+        if (body == nullptr) continue; // Removed since it was deactivated
+        movingSet.entities.push_back({ body->GetID(), body->GetUserData(), body->GetPosition() });
+    }
+}
+
+// Broadphase maintenance
+// Adding and removing bodies degrades the broadphase tree over time. Churn is
+// counted here and the tree is rebuilt at quiet points (level load, between
+// serves) once enough of it has been replaced to be worth the cost.
+struct BroadPhaseMaintenance {
+    int bodiesAdded = 0;
+    int bodiesRemoved = 0;
+    int minChurn = 8;           // Never optimize for less churn than this
+    float churnFraction = 0.25f; // ...or less than this fraction of all bodies
+};
+
+// Cost probe: a fixed fan of broadphase ray casts across the arena, in ms
+double MeasureBroadPhaseQueryCost(const PhysicsSystem& physicsSystem) {
+    const int cNumRays = 64;
+    AllHitCollisionCollector<RayCastBodyCollector> collector;
+
+    auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < cNumRays; i++) {
+        float x = -ARENA_WIDTH/2 + ARENA_WIDTH * (i + 0.5f) / cNumRays;
+        RayCast ray { Vec3(x, 2.0f, ARENA_DEPTH/2), Vec3(0.0f, 0.0f, -ARENA_DEPTH) };
+        collector.Reset(); // Otherwise hits pile up across rays
+        physicsSystem.GetBroadPhaseQuery().CastRay(ray, collector);
+    }
+    auto end = chrono::high_resolution_clock::now();
+
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+// Rebuild the broadphase if enough churn has accumulated. Only call this at
+// quiet points; pass force to always optimize (e.g. after loading a level).
+bool MaybeOptimizeBroadPhase(PhysicsSystem& physicsSystem, BroadPhaseMaintenance& maintenance, bool force = false) {
+    int churn = maintenance.bodiesAdded + maintenance.bodiesRemoved;
+    int threshold = max(maintenance.minChurn, (int)(physicsSystem.GetNumBodies() * maintenance.churnFraction));
+    if (!force && churn < threshold) return false;
+
+    double costBefore = MeasureBroadPhaseQueryCost(physicsSystem);
+    physicsSystem.OptimizeBroadPhase();
+    double costAfter = MeasureBroadPhaseQueryCost(physicsSystem);
+
+    cout << "Broadphase optimized after " << maintenance.bodiesAdded << " adds / " << maintenance.bodiesRemoved
+         << " removes: query cost " << costBefore << " ms -> " << costAfter << " ms" << endl;
+
+    maintenance.bodiesAdded = 0;
+    maintenance.bodiesRemoved = 0;
+    return true;
+}
+
+// Physics LOD
+// Dynamic bodies far from the focus point (the player) are put to sleep with
+// their velocities stashed, and woken with the same velocities once the focus
+// comes back in range. The gap between the two radii is hysteresis so bodies
+// near the boundary don't toggle every frame.
+//
+// Bodies are registered in groups that freeze and wake together, distance
+// being that of the group's nearest body. Jointed bodies have to be grouped:
+// Jolt wakes a sleeping body as soon as a constraint ties it to an awake one.
+// The ball is never registered; frozen, it would drop out of the moving set
+// and never be reset when it leaves the arena. The radii suit levels larger
+// than this arena, so --bench-chain exercises LOD with rows of chains far
+// from the focus.
+struct LodGroup {
+    BodyIDVector bodyIds;
+    bool frozen = false;
+    vector<Vec3> linearVelocities; // Per body, stashed while frozen
+    vector<Vec3> angularVelocities;
+};
+
+struct PhysicsLod {
+    float wakeRadius = 40.0f;
+    float freezeRadius = 50.0f;
+    int bodiesPerUpdate = 256; // Distance checks are spread over several frames
+    size_t cursor = 0;         // Next group to check
+    vector<LodGroup> groups;
+    BodyIDVector slice;         // Bodies of the groups checked this update
+    vector<size_t> sliceGroups;
+    BodyIDVector toFreeze;
+    BodyIDVector toWake;
+    vector<size_t> wakeGroups;
+};
+
+void RegisterLodGroup(PhysicsLod& lod, const BodyIDVector& bodyIds) {
+    if (bodyIds.empty()) return;
+    LodGroup group;
+    group.bodyIds = bodyIds;
+    group.linearVelocities.resize(bodyIds.size(), Vec3::sZero());
+    group.angularVelocities.resize(bodyIds.size(), Vec3::sZero());
+    lod.groups.push_back(std::move(group));
+}
+
+void UpdatePhysicsLod(PhysicsSystem& physicsSystem, PhysicsLod& lod, RVec3Arg focus) {
+    if (lod.groups.empty()) return;
+
+    lod.slice.clear();
+    lod.sliceGroups.clear();
+    lod.toFreeze.clear();
+    lod.toWake.clear();
+    lod.wakeGroups.clear();
+    float freezeRadiusSq = lod.freezeRadius * lod.freezeRadius;
+    float wakeRadiusSq = lod.wakeRadius * lod.wakeRadius;
+
+    // Whole groups, up to the budget but at least one
+    while (lod.sliceGroups.size() < lod.groups.size() && (int)lod.slice.size() < lod.bodiesPerUpdate) {
+        const LodGroup& group = lod.groups[lod.cursor];
+        lod.sliceGroups.push_back(lod.cursor);
+        lod.slice.insert(lod.slice.end(), group.bodyIds.begin(), group.bodyIds.end());
+        lod.cursor = (lod.cursor + 1) % lod.groups.size();
+    }
+
+    {
+        // Read the whole slice under one multi-body lock
+        BodyLockMultiRead lock(physicsSystem.GetBodyLockInterface(), lod.slice.data(), (int)lod.slice.size());
+        int first = 0;
+        for (size_t index : lod.sliceGroups) {
+            LodGroup& group = lod.groups[index];
+            int count = (int)group.bodyIds.size();
+            int offset = first;
+            first += count;
+
+            bool added = false;
+            bool active = false;
+            float nearestSq = FLT_MAX;
+            for (int i = 0; i < count; i++) {
+                const Body* body = lock.GetBody(offset + i);
+                if (body == nullptr || !body->IsInBroadPhase()) continue;
+                added = true;
+                active |= body->IsActive();
+                nearestSq = min(nearestSq, Vec3(body->GetPosition() - focus).LengthSq());
+            }
+            if (!added) continue;
+
+            // Something else (a collision, gameplay) woke it: the simulation owns it again
+            if (group.frozen && active) group.frozen = false;
+
+            if (!group.frozen && active && nearestSq > freezeRadiusSq) {
+                // Deactivating zeroes velocities, so keep them for the wake-up
+                for (int i = 0; i < count; i++) {
+                    const Body* body = lock.GetBody(offset + i);
+                    if (body == nullptr || !body->IsInBroadPhase()) continue;
+                    group.linearVelocities[i] = body->GetLinearVelocity();
+                    group.angularVelocities[i] = body->GetAngularVelocity();
+                    lod.toFreeze.push_back(group.bodyIds[i]);
+                }
+                group.frozen = true;
+            } else if (group.frozen && nearestSq < wakeRadiusSq) {
+                for (int i = 0; i < count; i++) {
+                    const Body* body = lock.GetBody(offset + i);
+                    if (body != nullptr && body->IsInBroadPhase()) lod.toWake.push_back(group.bodyIds[i]);
+                }
+                group.frozen = false;
+                lod.wakeGroups.push_back(index);
+            }
+        }
+    }
+
+    BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+    if (!lod.toFreeze.empty()) {
+        bodyInterface.DeactivateBodies(lod.toFreeze.data(), (int)lod.toFreeze.size());
+    }
+    if (!lod.toWake.empty()) {
+        bodyInterface.ActivateBodies(lod.toWake.data(), (int)lod.toWake.size());
+        for (size_t index : lod.wakeGroups) {
+            const LodGroup& group = lod.groups[index];
+            for (size_t i = 0; i < group.bodyIds.size(); i++) {
+                bodyInterface.SetLinearAndAngularVelocity(group.bodyIds[i], group.linearVelocities[i], group.angularVelocities[i]);
+            }
+        }
+    }
+}
+
+int CountFrozenBodies(const PhysicsLod& lod) {
+    int frozen = 0;
+    for (const LodGroup& group : lod.groups) {
+        if (group.frozen) frozen += (int)group.bodyIds.size();
+    }
+    return frozen;
+}
+
+// Screen body ownership
+// Every body a screen creates is recorded in one of its groups, so groups can
+// be torn down with one batched remove/destroy and screen exit leaks nothing.
+// Joints are owned the same way and removed before any of the bodies.
+enum class BodyGroup {
+    Level,   // Lives as long as the screen
+    Targets, // Rebuilt by ResetTargets
+    Count,
 };
 
+struct ScreenBodies {
+    BodyIDVector groups[(int)BodyGroup::Count];
+    Constraints constraints;
+};
+
+inline BodyIDVector& GetBodyGroup(ScreenBodies& screen, BodyGroup group) {
+    return screen.groups[(int)group];
+}
+
+// Remove and destroy every body in the group, returning how many were removed
+int DestroyBodyGroup(BodyInterface& bodyInterface, BodyIDVector& bodyIds) {
+    if (bodyIds.empty()) return 0;
+
+    // RemoveBodies requires added bodies and may reorder its input
+    BodyIDVector added;
+    added.reserve(bodyIds.size());
+    for (const BodyID& bodyId : bodyIds) {
+        if (bodyInterface.IsAdded(bodyId)) added.push_back(bodyId);
+    }
+    if (!added.empty()) {
+        bodyInterface.RemoveBodies(added.data(), (int)added.size());
+    }
+
+    bodyInterface.DestroyBodies(bodyIds.data(), (int)bodyIds.size());
+    bodyIds.clear();
+    return (int)added.size();
+}
+
+void TeardownScreen(PhysicsSystem& physicsSystem, ScreenBodies& screen) {
+    if (!screen.constraints.empty()) {
+        Array<Constraint*> constraints;
+        constraints.reserve(screen.constraints.size());
+        for (const Ref<Constraint>& constraint : screen.constraints) {
+            constraints.push_back(constraint.GetPtr());
+        }
+        physicsSystem.RemoveConstraints(constraints.data(), (int)constraints.size());
+        screen.constraints.clear();
+    }
+
+    for (BodyIDVector& group : screen.groups) {
+        DestroyBodyGroup(physicsSystem.GetBodyInterface(), group);
+    }
+}
+
 // Convert Jolt position to raylib Vector3
 Vector3 JoltToRaylib(const RVec3& v) {
     return { (float)v.GetX(), (float)v.GetY(), (float)v.GetZ() };
 }
 
-// Spawn a new target at random position
-Target CreateTarget(BodyInterface& bodyInterface, int index) {
+// Roll a new target at a random position. Runs on the main thread so targets
+// are rolled in the same order on every replay of a session.
+Target RollTarget(DeterministicRandom& random) {
     Target target;
 
     // Random position in the far half of the arena
-    float x = (float)GetRandomValue((int)(-ARENA_WIDTH/2 + 2), (int)(ARENA_WIDTH/2 - 2));
-    float y = (float)GetRandomValue(1, 4);
-    float z = (float)GetRandomValue((int)(-ARENA_DEPTH/2), (int)(-ARENA_DEPTH/4));
+    float x = (float)random.Range((int)(-ARENA_WIDTH/2 + 2), (int)(ARENA_WIDTH/2 - 2));
+    float y = (float)random.Range(1, 4);
+    float z = (float)random.Range((int)(-ARENA_DEPTH/2), (int)(-ARENA_DEPTH/4));
 
     target.position = { x, y, z };
     target.active = true;
@@ -251,251 +785,2045 @@ Target CreateTarget(BodyInterface& bodyInterface, int index) {
         target.points = 10;
     }
 
-    // Create physics body
+    return target;
+}
+
+// Stage times of one target build, in ms
+struct TargetBuildTimings {
+    double rollMs = 0.0;
+    double cookMs = 0.0;
+    double createMs = 0.0;
+    double addMs = 0.0;
+};
+
+void ReportTargetBuild(const TargetBuildTimings& timings) {
+    cout << "Built " << NUM_TARGETS << " targets: roll " << timings.rollMs << " ms, cook " << timings.cookMs
+         << " ms, create " << timings.createMs << " ms, add " << timings.addMs << " ms" << endl;
+}
+
+// Build targets through the staged loading pipeline:
+//   roll    - layouts on the main thread
+//   cook    - body creation settings on workers
+//   create  - bodies on workers, then IDs assigned in order on the main
+//             thread; Jolt's results depend on body IDs, so they must not
+//             depend on which worker finished first
+//   add     - one bulk insert into the broadphase
+TargetBuildTimings BuildTargets(BodyInterface& bodyInterface, GameState& gameState, BodyIDVector& owner, int count) {
+    const int cMinPerThread = 64;
+    TargetBuildTimings timings;
+    StageTimer timer;
+
+    size_t first = gameState.targets.size();
+    for (int i = 0; i < count; i++) {
+        gameState.targets.push_back(RollTarget(gameState.random));
+    }
+    timings.rollMs = timer.Lap();
+
+    // All targets share one shape
     BoxShapeSettings targetShapeSettings(Vec3(TARGET_SIZE/2, TARGET_SIZE/2, TARGET_SIZE/2));
     targetShapeSettings.SetEmbedded();
     ShapeRefC targetShape = targetShapeSettings.Create().Get();
 
-    BodyCreationSettings targetSettings(targetShape, RVec3(x, y, z), Quat::sIdentity(), EMotionType::Static, Layers::TARGET);
-    Body* targetBody = bodyInterface.CreateBody(targetSettings);
-    bodyInterface.AddBody(targetBody->GetID(), EActivation::DontActivate);
+    vector<BodyCreationSettings> settings(count);
+    ParallelFor(count, cMinPerThread, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            const Vector3& p = gameState.targets[first + i].position;
+            settings[i] = BodyCreationSettings(targetShape, RVec3(p.x, p.y, p.z), Quat::sIdentity(), EMotionType::Static, Layers::TARGET);
+            settings[i].mUserData = MakeEntityHandle(EntityType::Target, (uint32)(first + i));
+        }
+    });
+    timings.cookMs = timer.Lap();
 
-    target.bodyId = targetBody->GetID();
+    vector<Body*> bodies(count);
+    ParallelFor(count, cMinPerThread, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            bodies[i] = bodyInterface.CreateBodyWithoutID(settings[i]);
+        }
+    });
 
-    return target;
+    BodyIDVector bodyIds(count);
+    for (int i = 0; i < count; i++) {
+        if (bodies[i] != nullptr && !bodyInterface.AssignBodyID(bodies[i])) {
+            bodyInterface.DestroyBodyWithoutID(bodies[i]);
+            bodies[i] = nullptr;
+        }
+        bodyIds[i] = bodies[i] != nullptr ? bodies[i]->GetID() : BodyID();
+    }
+    timings.createMs = timer.Lap();
+
+    // Out of bodies: drop the targets that didn't get one
+    BodyIDVector added;
+    added.reserve(count);
+    for (int i = 0; i < count; i++) {
+        Target& target = gameState.targets[first + i];
+        target.bodyId = bodyIds[i];
+        if (bodyIds[i].IsInvalid()) {
+            target.active = false;
+        } else {
+            added.push_back(bodyIds[i]);
+        }
+    }
+    owner.insert(owner.end(), added.begin(), added.end());
+
+    // AddBodiesPrepare may reorder the array, so it gets its own copy
+    if (!added.empty()) {
+        BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(added.data(), (int)added.size());
+        bodyInterface.AddBodiesFinalize(added.data(), (int)added.size(), addState, EActivation::DontActivate);
+    }
+    timings.addMs = timer.Lap();
+    return timings;
 }
 
-// Reset targets
-void ResetTargets(BodyInterface& bodyInterface, GameState& gameState) {
-    // Remove old target bodies
-    for (auto& target : gameState.targets) {
-        if (bodyInterface.IsAdded(target.bodyId)) {
-            bodyInterface.RemoveBody(target.bodyId);
-            bodyInterface.DestroyBody(target.bodyId);
+// Reset targets. Once built, the target bodies are moved to the new layout
+// rather than destroyed and recreated, so every BodyID stays the same for the
+// arena's lifetime. Replay keyframes depend on that: Jolt restores state into
+// existing bodies by ID. When the bodies are built, their stage times go to
+// timings.
+void ResetTargets(BodyInterface& bodyInterface, GameState& gameState, ScreenBodies& screen, BroadPhaseMaintenance& maintenance,
+                  TargetBuildTimings* timings = nullptr) {
+    BodyIDVector& targetBodies = GetBodyGroup(screen, BodyGroup::Targets);
+    if ((int)targetBodies.size() == NUM_TARGETS && (int)gameState.targets.size() == NUM_TARGETS) {
+        for (Target& target : gameState.targets) {
+            BodyID bodyId = target.bodyId;
+            target = RollTarget(gameState.random);
+            target.bodyId = bodyId;
+            bodyInterface.SetPosition(bodyId, RVec3(target.position.x, target.position.y, target.position.z), EActivation::DontActivate);
         }
+        // Moving static bodies churns the broadphase as much as re-adding them
+        maintenance.bodiesAdded += NUM_TARGETS;
+        return;
     }
+
+    // Remove old target bodies in one batch
+    maintenance.bodiesRemoved += DestroyBodyGroup(bodyInterface, targetBodies);
     gameState.targets.clear();
 
     // Create new targets
-    for (int i = 0; i < NUM_TARGETS; i++) {
-        gameState.targets.push_back(CreateTarget(bodyInterface, i));
+    TargetBuildTimings built = BuildTargets(bodyInterface, gameState, targetBodies, NUM_TARGETS);
+    if (timings != nullptr) *timings = built;
+    maintenance.bodiesAdded += NUM_TARGETS;
+}
+
+// Joints
+// Screens describe joints with the engine-neutral JointDef (joint_defs.h).
+// They are created in bulk: settings and constraints are cooked on workers,
+// then added to the physics system in one call.
+
+// Links of one chain never collide with each other; the joints keep them apart
+class ChainGroupFilter : public GroupFilter {
+public:
+    virtual bool CanCollide(const CollisionGroup& inGroup1, const CollisionGroup& inGroup2) const override {
+        return inGroup1.GetGroupID() != inGroup2.GetGroupID();
     }
+};
+
+// Created on first use: Jolt's operator new needs RegisterDefaultAllocator(),
+// which hasn't run yet during static initialization
+GroupFilter* GetChainGroupFilter() {
+    static Ref<GroupFilter> filter = new ChainGroupFilter();
+    return filter;
 }
 
-int main(void) {
-    // Initialize raylib
-    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "3D Tennis Target Demo - Raylib + Jolt Physics");
-    SetTargetFPS(60);
+inline RVec3 ToJolt(const JointPoint& p) {
+    return RVec3(p.x, p.y, p.z);
+}
 
-    // Initialize Jolt
-    RegisterDefaultAllocator();
-    Trace = TraceImpl;
-    JPH_IF_ENABLE_ASSERTS(AssertFailed = AssertFailedImpl;)
-    Factory::sInstance = new Factory();
-    RegisterTypes();
+// Create the Jolt constraint for one joint. Either body may be
+// Body::sFixedToWorld.
+Ref<TwoBodyConstraint> CreateJointConstraint(const JointDef& joint, Body& bodyA, Body& bodyB, int solverSteps) {
+    Vec3 axis(joint.axis.x, joint.axis.y, joint.axis.z);
+    bool limited = joint.minLimit <= joint.maxLimit;
+    Ref<TwoBodyConstraintSettings> settings;
+
+    switch (joint.type) {
+    case JointType::Revolute:
+        if (axis.IsNearZero()) {
+            PointConstraintSettings* point = new PointConstraintSettings();
+            point->mSpace = EConstraintSpace::WorldSpace;
+            point->mPoint1 = point->mPoint2 = ToJolt(joint.anchorA);
+            settings = point;
+        } else {
+            HingeConstraintSettings* hinge = new HingeConstraintSettings();
+            hinge->mSpace = EConstraintSpace::WorldSpace;
+            hinge->mPoint1 = hinge->mPoint2 = ToJolt(joint.anchorA);
+            hinge->mHingeAxis1 = hinge->mHingeAxis2 = axis.Normalized();
+            hinge->mNormalAxis1 = hinge->mNormalAxis2 = axis.GetNormalizedPerpendicular();
+            if (limited) {
+                hinge->mLimitsMin = joint.minLimit;
+                hinge->mLimitsMax = joint.maxLimit;
+            }
+            settings = hinge;
+        }
+        break;
+
+    case JointType::Distance: {
+        DistanceConstraintSettings* distance = new DistanceConstraintSettings();
+        distance->mSpace = EConstraintSpace::WorldSpace;
+        distance->mPoint1 = ToJolt(joint.anchorA);
+        distance->mPoint2 = ToJolt(joint.anchorB);
+        if (limited) {
+            distance->mMinDistance = joint.minLimit;
+            distance->mMaxDistance = joint.maxLimit;
+        }
+        settings = distance;
+        break;
+    }
 
-    // Physics allocators
-    TempAllocatorImpl tempAllocator(10 * 1024 * 1024);
-    JobSystemThreadPool jobSystem(cMaxPhysicsJobs, cMaxPhysicsBarriers, thread::hardware_concurrency() - 1);
+    case JointType::Prismatic: {
+        SliderConstraintSettings* slider = new SliderConstraintSettings();
+        slider->mSpace = EConstraintSpace::WorldSpace;
+        slider->mPoint1 = slider->mPoint2 = ToJolt(joint.anchorA);
+        slider->SetSliderAxis(axis.NormalizedOr(Vec3::sAxisX()));
+        if (limited) {
+            slider->mLimitsMin = joint.minLimit;
+            slider->mLimitsMax = joint.maxLimit;
+        }
+        settings = slider;
+        break;
+    }
 
-    // Physics configuration
-    const uint cMaxBodies = 1024;
-    const uint cNumBodyMutexes = 0;
-    const uint cMaxBodyPairs = 1024;
-    const uint cMaxContactConstraints = 1024;
+    case JointType::Weld: {
+        FixedConstraintSettings* weld = new FixedConstraintSettings();
+        weld->mAutoDetectPoint = true;
+        settings = weld;
+        break;
+    }
+    }
 
-    // Layer interfaces
-    BPLayerInterfaceImpl broadPhaseLayerInterface;
-    ObjectVsBroadPhaseLayerFilterImpl objectVsBroadphaseLayerFilter;
-    ObjectLayerPairFilterImpl objectVsObjectLayerFilter;
+    settings->mConstraintPriority = joint.priority;
+    settings->mNumVelocityStepsOverride = solverSteps;
+    return settings->Create(bodyA, bodyB);
+}
 
-    // Create physics system
-    PhysicsSystem physicsSystem;
-    physicsSystem.Init(cMaxBodies, cNumBodyMutexes, cMaxBodyPairs, cMaxContactConstraints,
-                       broadPhaseLayerInterface, objectVsBroadphaseLayerFilter, objectVsObjectLayerFilter);
+// Create and add a batch of joints between bodies (indices into bodyIds).
+// Bodies must already exist; constraints are built in parallel and added in
+// one call, in the order given.
+void BuildJoints(PhysicsSystem& physicsSystem, const BodyIDVector& bodyIds, const vector<JointDef>& joints, int solverSteps, Constraints& owner) {
+    const int cMinPerThread = 256;
+    if (joints.empty()) return;
+
+    // Level load: nothing else touches these bodies, so no locking is needed
+    BodyLockMultiWrite lock(physicsSystem.GetBodyLockInterfaceNoLock(), bodyIds.data(), (int)bodyIds.size());
+    auto getBody = [&](int index) -> Body& {
+        Body* body = index == kWorldBody ? nullptr : lock.GetBody(index);
+        return body != nullptr ? *body : Body::sFixedToWorld;
+    };
+
+    vector<Ref<TwoBodyConstraint>> created(joints.size());
+    ParallelFor((int)joints.size(), cMinPerThread, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            created[i] = CreateJointConstraint(joints[i], getBody(joints[i].bodyA), getBody(joints[i].bodyB), solverSteps);
+        }
+    });
+
+    Array<Constraint*> batch;
+    batch.reserve(created.size());
+    owner.reserve(owner.size() + created.size());
+    for (const Ref<TwoBodyConstraint>& constraint : created) {
+        batch.push_back(constraint.GetPtr());
+        owner.push_back(constraint.GetPtr());
+    }
+    physicsSystem.AddConstraints(batch.data(), (int)batch.size());
+}
 
-    // Listeners
-    GameBodyActivationListener bodyActivationListener;
-    GameContactListener contactListener;
-    physicsSystem.SetBodyActivationListener(&bodyActivationListener);
-    physicsSystem.SetContactListener(&contactListener);
+// Solver order is what screens use; Shuffled exists to benchmark against it
+enum class JointOrder {
+    Solver,
+    Shuffled,
+};
+
+struct ChainBuildTimes {
+    double layoutMs;
+    double cookMs;
+    double createMs;
+    double addMs;
+    double jointMs;
+};
 
+// Build a chain through the same staged pipeline as targets: layout, cook
+// settings on workers, create bodies on workers with IDs assigned in order,
+// one bulk broadphase insert, then one batch of joints. Link entity indices
+// start at firstLink. Returns the link bodies in chain order.
+BodyIDVector BuildChain(PhysicsSystem& physicsSystem, const ChainDef& chain, uint32 groupId, uint32 firstLink,
+                        BodyIDVector& owner, Constraints& constraintOwner, ChainBuildTimes* times = nullptr,
+                        JointOrder order = JointOrder::Solver) {
+    const int cMinPerThread = 256;
     BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+    StageTimer timer;
 
-    // Create floor
-    BoxShapeSettings floorShapeSettings(Vec3(ARENA_WIDTH/2, 0.5f, ARENA_DEPTH/2));
-    floorShapeSettings.SetEmbedded();
-    ShapeRefC floorShape = floorShapeSettings.Create().Get();
-    BodyCreationSettings floorSettings(floorShape, RVec3(0.0_r, -0.5_r, 0.0_r), Quat::sIdentity(), EMotionType::Static, Layers::NON_MOVING);
-    Body* floor = bodyInterface.CreateBody(floorSettings);
-    bodyInterface.AddBody(floor->GetID(), EActivation::DontActivate);
+    ChainLayout layout = LayoutChain(chain);
+    if (order == JointOrder::Shuffled) {
+        DeterministicRandom random(groupId + 1);
+        for (int i = (int)layout.joints.size() - 1; i > 0; i--) {
+            swap(layout.joints[i], layout.joints[random.Range(0, i)]);
+        }
+        for (JointDef& joint : layout.joints) joint.priority = 0;
+    }
+    int count = (int)layout.linkPositions.size();
+    double layoutMs = timer.Lap();
+
+    SphereShapeSettings linkShapeSettings(chain.linkRadius);
+    linkShapeSettings.SetEmbedded();
+    ShapeRefC linkShape = linkShapeSettings.Create().Get();
+
+    GroupFilter* groupFilter = GetChainGroupFilter();
+    vector<BodyCreationSettings> settings(count);
+    ParallelFor(count, cMinPerThread, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            settings[i] = BodyCreationSettings(linkShape, ToJolt(layout.linkPositions[i]), Quat::sIdentity(), EMotionType::Dynamic, Layers::MOVING);
+            settings[i].mUserData = MakeEntityHandle(EntityType::ChainLink, firstLink + i);
+            settings[i].mCollisionGroup = CollisionGroup(groupFilter, groupId, (CollisionGroup::SubGroupID)i);
+            settings[i].mLinearDamping = 0.1f;
+            settings[i].mAngularDamping = 0.5f;
+        }
+    });
+    double cookMs = timer.Lap();
 
-    // Create walls
-    // Back wall
-    BoxShapeSettings backWallSettings(Vec3(ARENA_WIDTH/2, 5.0f, 0.5f));
-    backWallSettings.SetEmbedded();
-    ShapeRefC backWallShape = backWallSettings.Create().Get();
-    BodyCreationSettings backWallBodySettings(backWallShape, RVec3(0.0_r, 5.0_r, -ARENA_DEPTH/2), Quat::sIdentity(), EMotionType::Static, Layers::NON_MOVING);
-    Body* backWall = bodyInterface.CreateBody(backWallBodySettings);
-    bodyInterface.AddBody(backWall->GetID(), EActivation::DontActivate);
+    vector<Body*> bodies(count);
+    ParallelFor(count, cMinPerThread, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            bodies[i] = bodyInterface.CreateBodyWithoutID(settings[i]);
+        }
+    });
+
+    // A chain with missing links would come apart, so it is all or nothing
+    BodyIDVector linkIds;
+    linkIds.reserve(count);
+    for (int i = 0; i < count; i++) {
+        if (bodies[i] != nullptr && bodyInterface.AssignBodyID(bodies[i])) {
+            linkIds.push_back(bodies[i]->GetID());
+            continue;
+        }
+        cout << "Out of bodies building a " << count << " link chain" << endl;
+        for (int j = i; j < count; j++) {
+            if (bodies[j] != nullptr) bodyInterface.DestroyBodyWithoutID(bodies[j]);
+        }
+        if (!linkIds.empty()) bodyInterface.DestroyBodies(linkIds.data(), (int)linkIds.size());
+        return {};
+    }
+    double createMs = timer.Lap();
 
-    // Side walls
-    BoxShapeSettings sideWallSettings(Vec3(0.5f, 5.0f, ARENA_DEPTH/2));
-    sideWallSettings.SetEmbedded();
-    ShapeRefC sideWallShape = sideWallSettings.Create().Get();
+    BodyIDVector added = linkIds;
+    BodyInterface::AddState addState = bodyInterface.AddBodiesPrepare(added.data(), (int)added.size());
+    bodyInterface.AddBodiesFinalize(added.data(), (int)added.size(), addState, EActivation::Activate);
+    owner.insert(owner.end(), linkIds.begin(), linkIds.end());
+    double addMs = timer.Lap();
 
-    BodyCreationSettings leftWallSettings(sideWallShape, RVec3(-ARENA_WIDTH/2, 5.0_r, 0.0_r), Quat::sIdentity(), EMotionType::Static, Layers::NON_MOVING);
-    Body* leftWall = bodyInterface.CreateBody(leftWallSettings);
-    bodyInterface.AddBody(leftWall->GetID(), EActivation::DontActivate);
+    BuildJoints(physicsSystem, linkIds, layout.joints, chain.solverSteps, constraintOwner);
+    double jointMs = timer.Lap();
 
-    BodyCreationSettings rightWallSettings(sideWallShape, RVec3(ARENA_WIDTH/2, 5.0_r, 0.0_r), Quat::sIdentity(), EMotionType::Static, Layers::NON_MOVING);
-    Body* rightWall = bodyInterface.CreateBody(rightWallSettings);
-    bodyInterface.AddBody(rightWall->GetID(), EActivation::DontActivate);
+    if (times != nullptr) *times = { layoutMs, cookMs, createMs, addMs, jointMs };
+    return linkIds;
+}
 
-    // Create paddle (kinematic - player controlled)
-    BoxShapeSettings paddleShapeSettings(Vec3(PADDLE_WIDTH/2, PADDLE_HEIGHT/2, PADDLE_DEPTH/2));
-    paddleShapeSettings.SetEmbedded();
-    ShapeRefC paddleShape = paddleShapeSettings.Create().Get();
+// Chain benchmark
+// Builds one long chain, pinned at one end and released horizontally, in its
+// own physics system and lets it swing. Reports the build stages, the
+// average step time and how far the links have pulled apart by the end.
+struct ChainBenchResult {
+    ChainBuildTimes build;
+    double stepMs;
+    float maxStretch; // Worst link gap beyond its rest length, in link lengths
+};
 
-    Vector3 paddlePos = { 0.0f, 1.0f, ARENA_DEPTH/2 - 3.0f };
-    BodyCreationSettings paddleSettings(paddleShape, RVec3(paddlePos.x, paddlePos.y, paddlePos.z), Quat::sIdentity(), EMotionType::Kinematic, Layers::PADDLE);
-    Body* paddle = bodyInterface.CreateBody(paddleSettings);
-    bodyInterface.AddBody(paddle->GetID(), EActivation::Activate);
-    BodyID paddleId = paddle->GetID();
+ChainBenchResult RunChainBenchmark(int links, int numThreads, int ticks, JointOrder order) {
+    TempAllocatorImpl tempAllocator(64 * 1024 * 1024);
+    JobSystemThreadPool jobSystem;
+    jobSystem.Init(cMaxPhysicsJobs, cMaxPhysicsBarriers, max(0, numThreads - 1));
 
-    // Create ball (dynamic)
-    SphereShapeSettings ballShapeSettings(BALL_RADIUS);
-    ballShapeSettings.SetEmbedded();
-    ShapeRefC ballShape = ballShapeSettings.Create().Get();
+    BPLayerInterfaceImpl broadPhaseLayerInterface;
+    ObjectVsBroadPhaseLayerFilterImpl objectVsBroadphaseLayerFilter;
+    ObjectLayerPairFilterImpl objectVsObjectLayerFilter;
+    PhysicsSystem physicsSystem;
+    physicsSystem.Init(links + 16, 0, links * 4, links * 4,
+                       broadPhaseLayerInterface, objectVsBroadphaseLayerFilter, objectVsObjectLayerFilter);
 
-    Vector3 ballStartPos = { paddlePos.x, paddlePos.y + 1.0f, paddlePos.z - 1.0f };
-    BodyCreationSettings ballSettings(ballShape, RVec3(ballStartPos.x, ballStartPos.y, ballStartPos.z), Quat::sIdentity(), EMotionType::Dynamic, Layers::MOVING);
-    ballSettings.mRestitution = 0.8f;
-    ballSettings.mFriction = 0.2f;
-    Body* ball = bodyInterface.CreateBody(ballSettings);
-    bodyInterface.AddBody(ball->GetID(), EActivation::Activate);
-    gBallId = ball->GetID();
+    ChainDef chain;
+    chain.start = { 0.0f, 0.0f, 0.0f };
+    chain.end = { links * 0.2f, 0.0f, 0.0f };
+    chain.links = links;
+    chain.linkRadius = 0.08f;
+    chain.slack = 0.0f;
+    chain.jointType = JointType::Revolute;
+    chain.anchorStart = true;
+    chain.anchorEnd = false;
+    chain.solverSteps = 0;
+
+    ChainBenchResult result = {};
+    BodyIDVector bodies;
+    Constraints constraints;
+    BodyIDVector linkIds = BuildChain(physicsSystem, chain, 0, 0, bodies, constraints, &result.build, order);
+    physicsSystem.OptimizeBroadPhase();
 
-    // Game state
-    GameState gameState;
-    gGameState = &gameState;
+    StageTimer timer;
+    for (int tick = 0; tick < ticks; tick++) {
+        physicsSystem.Update(1.0f / 60.0f, 1, &tempAllocator, &jobSystem);
+    }
+    result.stepMs = timer.Lap() / max(1, ticks);
+
+    float linkLength = LayoutChain(chain).linkLength;
+    {
+        BodyLockMultiRead lock(physicsSystem.GetBodyLockInterface(), linkIds.data(), (int)linkIds.size());
+        RVec3 previous = ToJolt(chain.start);
+        for (int i = 0; i < (int)linkIds.size(); i++) {
+            const Body* body = lock.GetBody(i);
+            if (body == nullptr) continue;
+            RVec3 position = body->GetPosition();
+            float rest = i == 0 ? 0.5f * linkLength : linkLength;
+            result.maxStretch = max(result.maxStretch, ((float)Vec3(position - previous).Length() - rest) / linkLength);
+            previous = position;
+        }
+    }
 
-    // Create initial targets
-    ResetTargets(bodyInterface, gameState);
+    Array<Constraint*> batch;
+    for (const Ref<Constraint>& constraint : constraints) batch.push_back(constraint.GetPtr());
+    physicsSystem.RemoveConstraints(batch.data(), (int)batch.size());
+    DestroyBodyGroup(physicsSystem.GetBodyInterface(), bodies);
+    return result;
+}
 
-    // Optimize broad phase
-    physicsSystem.OptimizeBroadPhase();
+// Physics LOD over short chains in a row running away from a focus at the
+// origin. After stepping with LOD, the focus jumps to the far end of the row
+// and every group is checked once, so the far chains should wake and the
+// near ones freeze.
+struct LodBenchResult {
+    double stepMs;
+    int frozenLinks;     // At the end of the run
+    int frozenAfterMove; // Once the focus has moved
+};
 
-    // Camera setup - third person
-    Camera3D camera = { 0 };
-    camera.position = { 0.0f, 15.0f, 25.0f };
-    camera.target = { 0.0f, 2.0f, 0.0f };
-    camera.up = { 0.0f, 1.0f, 0.0f };
-    camera.fovy = 45.0f;
-    camera.projection = CAMERA_PERSPECTIVE;
+LodBenchResult RunLodBenchmark(int links, int numThreads, int ticks, bool useLod) {
+    const int cLinksPerChain = 50;
+    const float cChainSpacing = 10.0f;
 
-    const float deltaTime = 1.0f / 60.0f;
-    bool gameOver = false;
+    TempAllocatorImpl tempAllocator(64 * 1024 * 1024);
+    JobSystemThreadPool jobSystem;
+    jobSystem.Init(cMaxPhysicsJobs, cMaxPhysicsBarriers, max(0, numThreads - 1));
 
-    // Main game loop
-    while (!WindowShouldClose()) {
-        // Input handling - paddle movement
-        float moveX = 0.0f;
-        float moveZ = 0.0f;
-
-        if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT))  moveX -= PADDLE_SPEED * deltaTime;
-        if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) moveX += PADDLE_SPEED * deltaTime;
-        if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP))    moveZ -= PADDLE_SPEED * deltaTime;
-        if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN))  moveZ += PADDLE_SPEED * deltaTime;
-
-        // Update paddle position
-        RVec3 currentPaddlePos = bodyInterface.GetPosition(paddleId);
-        float newX = Clamp((float)currentPaddlePos.GetX() + moveX, -ARENA_WIDTH/2 + PADDLE_WIDTH, ARENA_WIDTH/2 - PADDLE_WIDTH);
-        float newZ = Clamp((float)currentPaddlePos.GetZ() + moveZ, 0.0f, ARENA_DEPTH/2 - 2.0f);
-        bodyInterface.SetPosition(paddleId, RVec3(newX, currentPaddlePos.GetY(), newZ), EActivation::Activate);
-        paddlePos = { newX, (float)currentPaddlePos.GetY(), newZ };
-
-        // Launch ball with space
-        if (IsKeyPressed(KEY_SPACE) && !gameState.ballInPlay && gameState.ballsRemaining > 0) {
-            gameState.ballInPlay = true;
-            gameState.ballsRemaining--;
-
-            // Reset ball position above paddle
-            bodyInterface.SetPosition(gBallId, RVec3(paddlePos.x, paddlePos.y + 1.0f, paddlePos.z - 1.0f), EActivation::Activate);
+    BPLayerInterfaceImpl broadPhaseLayerInterface;
+    ObjectVsBroadPhaseLayerFilterImpl objectVsBroadphaseLayerFilter;
+    ObjectLayerPairFilterImpl objectVsObjectLayerFilter;
+    PhysicsSystem physicsSystem;
+    physicsSystem.Init(links + 16, 0, links * 4, links * 4,
+                       broadPhaseLayerInterface, objectVsBroadphaseLayerFilter, objectVsObjectLayerFilter);
+
+    PhysicsLod lod;
+    BodyIDVector bodies;
+    Constraints constraints;
+    int chains = max(1, links / cLinksPerChain);
+    for (int c = 0; c < chains; c++) {
+        ChainDef chain;
+        chain.start = { 0.0f, 0.0f, c * cChainSpacing };
+        chain.end = { cLinksPerChain * 0.2f, 0.0f, c * cChainSpacing };
+        chain.links = cLinksPerChain;
+        chain.linkRadius = 0.08f;
+        chain.slack = 0.0f;
+        chain.jointType = JointType::Revolute;
+        chain.anchorStart = true;
+        chain.anchorEnd = false;
+        chain.solverSteps = 0;
+        BodyIDVector linkIds = BuildChain(physicsSystem, chain, (uint32)c, (uint32)(c * cLinksPerChain), bodies, constraints);
+        if (useLod) RegisterLodGroup(lod, linkIds);
+    }
+    physicsSystem.OptimizeBroadPhase();
+
+    LodBenchResult result = {};
+    StageTimer timer;
+    for (int tick = 0; tick < ticks; tick++) {
+        if (useLod) UpdatePhysicsLod(physicsSystem, lod, RVec3::sZero());
+        physicsSystem.Update(1.0f / 60.0f, 1, &tempAllocator, &jobSystem);
+    }
+    result.stepMs = timer.Lap() / max(1, ticks);
+    result.frozenLinks = CountFrozenBodies(lod);
+
+    // Each update checks at least one group, so this covers all of them
+    RVec3 farEnd(0.0_r, 0.0_r, (chains - 1) * cChainSpacing);
+    for (size_t i = 0; i < lod.groups.size(); i++) UpdatePhysicsLod(physicsSystem, lod, farEnd);
+    result.frozenAfterMove = CountFrozenBodies(lod);
+
+    Array<Constraint*> batch;
+    for (const Ref<Constraint>& constraint : constraints) batch.push_back(constraint.GetPtr());
+    physicsSystem.RemoveConstraints(batch.data(), (int)batch.size());
+    DestroyBodyGroup(physicsSystem.GetBodyInterface(), bodies);
+    return result;
+}
+
+int BenchmarkChains(int links, const vector<int>& threadCounts, int ticks) {
+    cout << "Chain benchmark: " << links << " links, " << ticks << " ticks" << endl;
+    for (int numThreads : threadCounts) {
+        for (JointOrder order : { JointOrder::Solver, JointOrder::Shuffled }) {
+            ChainBenchResult result = RunChainBenchmark(links, numThreads, ticks, order);
+            const ChainBuildTimes& build = result.build;
+            printf("  %2d threads, %-8s build %7.2f ms (cook %.2f, create %.2f, add %.2f, joints %.2f)  step %7.3f ms  stretch %.3f\n",
+                numThreads, order == JointOrder::Solver ? "ordered" : "shuffled",
+                build.layoutMs + build.cookMs + build.createMs + build.addMs + build.jointMs,
+                build.cookMs, build.createMs, build.addMs, build.jointMs, result.stepMs, result.maxStretch);
+        }
+        LodBenchResult awake = RunLodBenchmark(links, numThreads, ticks, false);
+        LodBenchResult lod = RunLodBenchmark(links, numThreads, ticks, true);
+        printf("  %2d threads, LOD      step %7.3f ms without, %7.3f ms with  frozen %d links, %d after moving the focus\n",
+            numThreads, awake.stepMs, lod.stepMs, lod.frozenLinks, lod.frozenAfterMove);
+    }
+    return 0;
+}
+
+// Soft bodies
+// Cloth and jelly entities backed by Jolt soft bodies. The shared settings
+// (vertices, faces and constraints) are cached per description, so every flag
+// of the same size shares one copy. PhysicsSystem::Update solves soft bodies
+// on the job system alongside everything else.
+//
+// Vertices are read back on a worker into the back half of a double buffer
+// while the frame renders the front half. The halves swap once the readback
+// is done, just before the next physics update, so rendering never waits on
+// physics and physics never races the readback.
+enum class SoftBodyKind {
+    Cloth, // Hanging sheet, optionally pinned along its top edge
+    Jelly, // Closed pressurized cube
+};
+
+struct SoftBodyDesc {
+    SoftBodyKind kind;
+    int resolution;   // Vertices along each edge
+    float size;       // Cloth width and height, or jelly edge length
+    float compliance; // Edge compliance, 0 is as stiff as the solver allows
+    bool pinTopEdge;  // Cloth only
+};
+
+class SoftBodySettingsCache {
+public:
+    Ref<SoftBodySharedSettings> Get(const SoftBodyDesc& desc) {
+        auto key = make_tuple((int)desc.kind, desc.resolution, desc.size, desc.compliance, desc.pinTopEdge);
+        auto it = mSettings.find(key);
+        if (it != mSettings.end()) return it->second;
+
+        Ref<SoftBodySharedSettings> settings = desc.kind == SoftBodyKind::Cloth ? CreateCloth(desc) : CreateJelly(desc);
+        SoftBodySharedSettings::VertexAttributes attributes(desc.compliance, desc.compliance, desc.compliance);
+        settings->CreateConstraints(&attributes, 1, SoftBodySharedSettings::EBendType::Distance);
+        // Groups the constraints so one soft body can be solved on several threads
+        settings->Optimize();
+
+        mSettings[key] = settings;
+        return settings;
+    }
+
+    size_t GetSize() const { return mSettings.size(); }
+
+private:
+    // Grid in the XY plane hanging down from y = 0
+    static Ref<SoftBodySharedSettings> CreateCloth(const SoftBodyDesc& desc) {
+        Ref<SoftBodySharedSettings> settings = new SoftBodySharedSettings();
+        int n = max(2, desc.resolution);
+        float step = desc.size / (n - 1);
+
+        for (int y = 0; y < n; y++) {
+            for (int x = 0; x < n; x++) {
+                SoftBodySharedSettings::Vertex vertex;
+                vertex.mPosition = Float3(x * step - desc.size / 2, -y * step, 0.0f);
+                vertex.mInvMass = desc.pinTopEdge && y == 0 ? 0.0f : 1.0f;
+                settings->mVertices.push_back(vertex);
+            }
+        }
+        for (int y = 0; y < n - 1; y++) {
+            for (int x = 0; x < n - 1; x++) {
+                uint32 v00 = y * n + x, v10 = v00 + 1, v01 = v00 + n, v11 = v01 + 1;
+                settings->mFaces.push_back(SoftBodySharedSettings::Face(v00, v01, v11));
+                settings->mFaces.push_back(SoftBodySharedSettings::Face(v00, v11, v10));
+            }
+        }
+        return settings;
+    }
+
+    // Surface of a cube centered on the origin, faces wound outward so
+    // pressure pushes the right way. Edge vertices are shared between sides.
+    static Ref<SoftBodySharedSettings> CreateJelly(const SoftBodyDesc& desc) {
+        Ref<SoftBodySharedSettings> settings = new SoftBodySharedSettings();
+        int n = max(2, desc.resolution);
+        int cells = n - 1;
+        float unit = desc.size / (2 * cells);
+
+        // Each side as normal, u, v with u x v = normal
+        static const int sides[6][3][3] = {
+            { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } },
+            { { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+            { { 0, 1, 0 }, { 0, 0, 1 }, { 1, 0, 0 } },
+            { { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+            { { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+            { { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } },
+        };
+
+        // Vertices keyed by their integer lattice coordinates
+        map<tuple<int, int, int>, uint32> lattice;
+        auto vertexAt = [&](const int (*side)[3], int i, int j) {
+            int p[3];
+            for (int axis = 0; axis < 3; axis++) {
+                p[axis] = side[0][axis] * cells + side[1][axis] * (2 * i - cells) + side[2][axis] * (2 * j - cells);
+            }
+            auto key = make_tuple(p[0], p[1], p[2]);
+            auto it = lattice.find(key);
+            if (it != lattice.end()) return it->second;
+
+            SoftBodySharedSettings::Vertex vertex;
+            vertex.mPosition = Float3(p[0] * unit, p[1] * unit, p[2] * unit);
+            uint32 index = (uint32)settings->mVertices.size();
+            settings->mVertices.push_back(vertex);
+            lattice[key] = index;
+            return index;
+        };
+
+        for (const auto& side : sides) {
+            for (int j = 0; j < cells; j++) {
+                for (int i = 0; i < cells; i++) {
+                    uint32 v00 = vertexAt(side, i, j), v10 = vertexAt(side, i + 1, j);
+                    uint32 v11 = vertexAt(side, i + 1, j + 1), v01 = vertexAt(side, i, j + 1);
+                    settings->mFaces.push_back(SoftBodySharedSettings::Face(v00, v10, v11));
+                    settings->mFaces.push_back(SoftBodySharedSettings::Face(v00, v11, v01));
+                }
+            }
+        }
+        return settings;
+    }
+
+    map<tuple<int, int, float, float, bool>, Ref<SoftBodySharedSettings>> mSettings;
+};
+
+// World space vertex positions plus a shaded color per vertex, ready to copy
+// into a dynamic mesh
+struct SoftBodyFrame {
+    vector<float> positions;       // xyz per vertex
+    vector<unsigned char> colors;  // rgba per vertex
+};
+
+struct SoftBodyEntity {
+    BodyID bodyId;
+    Ref<SoftBodySharedSettings> settings;
+    RayColor color;
+    bool twoSided;
+    SoftBodyFrame frames[2];
+    int front = 0;
+};
+
+struct SoftBodySet {
+    SoftBodySettingsCache cache;
+    vector<SoftBodyEntity> entities;
+    JobSystem::Barrier* readbackBarrier = nullptr;
+    bool readbackPending = false;
+};
+
+// Fill frame from the body's current vertices. Normals are averaged from the
+// faces and turned into a simple directional shade.
+void ReadSoftBodyFrame(const PhysicsSystem& physicsSystem, const SoftBodyEntity& entity, SoftBodyFrame& frame) {
+    BodyLockRead lock(physicsSystem.GetBodyLockInterface(), entity.bodyId);
+    if (!lock.Succeeded()) return;
+
+    const Body& body = lock.GetBody();
+    const SoftBodyMotionProperties* motion = static_cast<const SoftBodyMotionProperties*>(body.GetMotionProperties());
+    const Array<SoftBodyVertex>& vertices = motion->GetVertices();
+    RMat44 transform = body.GetCenterOfMassTransform();
+
+    size_t count = vertices.size();
+    frame.positions.resize(count * 3);
+    frame.colors.resize(count * 4);
+    vector<Vec3> world(count);
+    vector<Vec3> normals(count, Vec3::sZero());
+    for (size_t i = 0; i < count; i++) {
+        world[i] = Vec3(transform * vertices[i].mPosition);
+        frame.positions[i * 3 + 0] = world[i].GetX();
+        frame.positions[i * 3 + 1] = world[i].GetY();
+        frame.positions[i * 3 + 2] = world[i].GetZ();
+    }
+    for (const SoftBodySharedSettings::Face& face : entity.settings->mFaces) {
+        Vec3 normal = (world[face.mVertex[1]] - world[face.mVertex[0]]).Cross(world[face.mVertex[2]] - world[face.mVertex[0]]);
+        for (uint32 vertex : face.mVertex) normals[vertex] += normal;
+    }
+
+    const Vec3 light = Vec3(0.3f, 1.0f, 0.5f).Normalized();
+    for (size_t i = 0; i < count; i++) {
+        float facing = normals[i].NormalizedOr(Vec3::sAxisY()).Dot(light);
+        if (entity.twoSided) facing = abs(facing);
+        float shade = 0.35f + 0.65f * max(0.0f, facing);
+        frame.colors[i * 4 + 0] = (unsigned char)(entity.color.r * shade);
+        frame.colors[i * 4 + 1] = (unsigned char)(entity.color.g * shade);
+        frame.colors[i * 4 + 2] = (unsigned char)(entity.color.b * shade);
+        frame.colors[i * 4 + 3] = entity.color.a;
+    }
+}
+
+BodyID CreateSoftBodyEntity(BodyInterface& bodyInterface, SoftBodySet& set, const SoftBodyDesc& desc, RVec3Arg position,
+                            RayColor color, BodyIDVector& owner) {
+    SoftBodyEntity entity;
+    entity.settings = set.cache.Get(desc);
+    entity.color = color;
+    entity.twoSided = desc.kind == SoftBodyKind::Cloth;
+
+    SoftBodyCreationSettings settings(entity.settings, position, Quat::sIdentity(), Layers::MOVING);
+    settings.mUserData = MakeEntityHandle(EntityType::SoftBody, (uint32)set.entities.size());
+    if (desc.kind == SoftBodyKind::Jelly) {
+        settings.mPressure = 2000.0f;
+        settings.mRestitution = 0.3f;
+    }
+
+    Body* body = bodyInterface.CreateSoftBody(settings);
+    if (body == nullptr) {
+        cout << "Out of bodies creating a soft body" << endl;
+        return BodyID();
+    }
+    bodyInterface.AddBody(body->GetID(), EActivation::Activate);
+    entity.bodyId = body->GetID();
+    owner.push_back(entity.bodyId);
+    set.entities.push_back(std::move(entity));
+    return set.entities.back().bodyId;
+}
+
+// Kick off reading every soft body into its back buffer. Physics must not
+// update again until FinishSoftBodyReadback.
+void StartSoftBodyReadback(const PhysicsSystem& physicsSystem, JobSystem& jobSystem, SoftBodySet& set) {
+    if (set.entities.empty()) return;
+    if (set.readbackBarrier == nullptr) set.readbackBarrier = jobSystem.CreateBarrier();
+
+    for (SoftBodyEntity& entity : set.entities) {
+        SoftBodyEntity* target = &entity;
+        JobSystem::JobHandle job = jobSystem.CreateJob("SoftBodyReadback", JPH::Color::sGreen, [&physicsSystem, target]() {
+            ReadSoftBodyFrame(physicsSystem, *target, target->frames[1 - target->front]);
+        });
+        set.readbackBarrier->AddJob(job);
+    }
+    set.readbackPending = true;
+}
+
+// Wait for the readback (normally long done) and present it
+void FinishSoftBodyReadback(JobSystem& jobSystem, SoftBodySet& set) {
+    if (!set.readbackPending) return;
+    jobSystem.WaitForJobs(set.readbackBarrier);
+    for (SoftBodyEntity& entity : set.entities) {
+        entity.front = 1 - entity.front;
+    }
+    set.readbackPending = false;
+}
+
+void ShutdownSoftBodies(JobSystem& jobSystem, SoftBodySet& set) {
+    FinishSoftBodyReadback(jobSystem, set);
+    if (set.readbackBarrier != nullptr) jobSystem.DestroyBarrier(set.readbackBarrier);
+    set.readbackBarrier = nullptr;
+    set.entities.clear();
+}
+
+// raylib meshes index vertices with unsigned short
+const int MAX_SOFT_BODY_MESH_VERTICES = 65536;
+
+// Dynamic mesh for one soft body. Faces are fixed, so only positions and
+// colors are re-uploaded each frame. Bodies with more vertices than 16-bit
+// indices can address get an empty mesh (vertexCount 0) and aren't drawn.
+Mesh CreateSoftBodyMesh(const SoftBodyEntity& entity) {
+    const SoftBodyFrame& frame = entity.frames[entity.front];
+    Mesh mesh = { 0 };
+    int vertexCount = (int)frame.positions.size() / 3;
+    if (vertexCount > MAX_SOFT_BODY_MESH_VERTICES) {
+        cout << "Soft body has " << vertexCount << " vertices, more than a mesh can index ("
+             << MAX_SOFT_BODY_MESH_VERTICES << "); not drawn" << endl;
+        return mesh;
+    }
+    mesh.vertexCount = vertexCount;
+    mesh.triangleCount = (int)entity.settings->mFaces.size();
+    mesh.vertices = (float*)MemAlloc(mesh.vertexCount * 3 * sizeof(float));
+    mesh.colors = (unsigned char*)MemAlloc(mesh.vertexCount * 4);
+    mesh.indices = (unsigned short*)MemAlloc(mesh.triangleCount * 3 * sizeof(unsigned short));
+    memcpy(mesh.vertices, frame.positions.data(), frame.positions.size() * sizeof(float));
+    memcpy(mesh.colors, frame.colors.data(), frame.colors.size());
+    for (int i = 0; i < mesh.triangleCount; i++) {
+        for (int corner = 0; corner < 3; corner++) {
+            uint32 vertex = entity.settings->mFaces[i].mVertex[corner];
+            JPH_ASSERT(vertex < (uint32)mesh.vertexCount && vertex < (uint32)MAX_SOFT_BODY_MESH_VERTICES);
+            mesh.indices[i * 3 + corner] = (unsigned short)vertex;
+        }
+    }
+    UploadMesh(&mesh, true);
+    return mesh;
+}
+
+void UpdateSoftBodyMesh(Mesh& mesh, const SoftBodyEntity& entity) {
+    const SoftBodyFrame& frame = entity.frames[entity.front];
+    if ((int)frame.positions.size() != mesh.vertexCount * 3) return;
+    UpdateMeshBuffer(mesh, 0, frame.positions.data(), (int)(frame.positions.size() * sizeof(float)), 0);
+    UpdateMeshBuffer(mesh, 3, frame.colors.data(), (int)frame.colors.size(), 0);
+}
+
+// Explosions
+// Queued during the game update and applied together just before the physics
+// step: one broadphase sphere query per explosion, one locked pass over the
+// bodies they reached summing each body's impulse, and one batched wake.
+// Each explosion only costs the bodies inside its own radius, however far
+// apart the explosions are.
+struct ExplosionQueue {
+    vector<ExplosionDef> pending;
+    vector<pair<BodyID, int>> overlaps; // Scratch, kept to avoid reallocating every step: body, explosion
+    BodyIDVector hits;
+    BodyIDVector toWake;
+};
+
+void QueueExplosion(ExplosionQueue& queue, const ExplosionDef& def) {
+    if (def.radius > 0.0f && def.impulse != 0.0f) queue.pending.push_back(def);
+}
+
+// Returns the number of bodies pushed
+int ApplyExplosions(PhysicsSystem& physicsSystem, ExplosionQueue& queue) {
+    if (queue.pending.empty()) return 0;
+
+    const BroadPhaseQuery& broadPhase = physicsSystem.GetBroadPhaseQuery();
+    AllHitCollisionCollector<CollideShapeBodyCollector> collector;
+    queue.overlaps.clear();
+    for (int e = 0; e < (int)queue.pending.size(); e++) {
+        const ExplosionDef& def = queue.pending[e];
+        collector.Reset();
+        broadPhase.CollideSphere(Vec3(def.x, def.y, def.z), def.radius, collector,
+            SpecifiedBroadPhaseLayerFilter(BroadPhaseLayers::MOVING));
+        for (const BodyID& id : collector.mHits) queue.overlaps.push_back({ id, e });
+    }
+    // Broadphase order depends on tree layout; body ID order keeps replays
+    // exact, and explosion order within a body keeps its impulse sum exact
+    sort(queue.overlaps.begin(), queue.overlaps.end());
+
+    queue.hits.clear();
+    for (const pair<BodyID, int>& overlap : queue.overlaps) {
+        if (queue.hits.empty() || queue.hits.back() != overlap.first) queue.hits.push_back(overlap.first);
+    }
+
+    int pushed = 0;
+    queue.toWake.clear();
+    {
+        BodyLockMultiWrite lock(physicsSystem.GetBodyLockInterface(), queue.hits.data(), (int)queue.hits.size());
+        size_t next = 0;
+        for (int i = 0; i < (int)queue.hits.size(); i++) {
+            // This body's overlaps are the next run in the sorted list
+            size_t first = next;
+            while (next < queue.overlaps.size() && queue.overlaps[next].first == queue.hits[i]) next++;
+
+            Body* body = lock.GetBody(i);
+            if (body == nullptr || !body->IsRigidBody() || !body->IsDynamic()) continue;
+
+            Vec3 position = Vec3(body->GetCenterOfMassPosition());
+            Vec3 impulse = Vec3::sZero();
+            for (size_t o = first; o < next; o++) {
+                const ExplosionDef& def = queue.pending[queue.overlaps[o].second];
+                Vec3 offset = position - Vec3(def.x, def.y, def.z);
+                float distance = offset.Length();
+                float scale = ExplosionScale(def.falloff, distance, def.radius);
+                if (scale <= 0.0f) continue;
+                // Straight up when sitting on the center
+                Vec3 direction = distance > 1.0e-4f ? offset / distance : Vec3::sAxisY();
+                impulse += direction * (def.impulse * scale);
+            }
+            if (impulse.IsNearZero()) continue;
+
+            body->AddImpulse(impulse);
+            pushed++;
+            if (!body->IsActive()) queue.toWake.push_back(body->GetID());
+        }
+    }
+    if (!queue.toWake.empty()) {
+        physicsSystem.GetBodyInterface().ActivateBodies(queue.toWake.data(), (int)queue.toWake.size());
+    }
+
+    queue.pending.clear();
+    return pushed;
+}
+
+// Force fields
+// Applied once per step before the physics update. Each field queries the
+// broadphase with its own bounds, so a wide wind volume doesn't drag a distant
+// well's neighbourhood in with it. The bodies found are gathered into a
+// ForceFieldBatch under one multi-body lock, every wind and well field runs
+// over the batch in a single pass, and each body then gets one force.
+// Buoyancy goes through Jolt's ApplyBuoyancyImpulse for bodies touching water.
+//
+// Sleeping bodies are left alone unless their center is inside a field and
+// the push on them is more than kFieldWakeAcceleration, so settled bodies at
+// the edge of a field or under a light breeze stay asleep.
+constexpr float kFieldWakeAcceleration = 0.5f; // m/s^2
+
+struct ForceFieldState {
+    vector<ForceFieldDef> fields;
+    ForceFieldBatch batch;  // Scratch, reused every step
+    BodyIDVector hits;
+    vector<Body*> bodies;   // Parallel to the batch
+    BodyIDVector toWake;
+};
+
+// Returns the number of bodies affected by any field
+int ApplyForceFields(PhysicsSystem& physicsSystem, ForceFieldState& state, float deltaTime) {
+    if (state.fields.empty()) return 0;
+
+    const BroadPhaseQuery& broadPhase = physicsSystem.GetBroadPhaseQuery();
+    AllHitCollisionCollector<CollideShapeBodyCollector> collector;
+    state.hits.clear();
+    for (const ForceFieldDef& field : state.fields) {
+        collector.Reset();
+        if (field.type == ForceFieldType::GravityWell) {
+            broadPhase.CollideSphere(Vec3(field.center[0], field.center[1], field.center[2]), field.radius, collector,
+                SpecifiedBroadPhaseLayerFilter(BroadPhaseLayers::MOVING));
+        } else {
+            float min[3], max[3];
+            ForceFieldBounds(field, min, max);
+            broadPhase.CollideAABox(AABox(Vec3(min[0], min[1], min[2]), Vec3(max[0], max[1], max[2])), collector,
+                SpecifiedBroadPhaseLayerFilter(BroadPhaseLayers::MOVING));
+        }
+        state.hits.insert(state.hits.end(), collector.mHits.begin(), collector.mHits.end());
+    }
+    // Deterministic order, see ApplyExplosions; bodies in several fields once
+    sort(state.hits.begin(), state.hits.end());
+    state.hits.erase(unique(state.hits.begin(), state.hits.end()), state.hits.end());
+
+    int affected = 0;
+    state.batch.Clear();
+    state.bodies.clear();
+    state.toWake.clear();
+    {
+        BodyLockMultiWrite lock(physicsSystem.GetBodyLockInterface(), state.hits.data(), (int)state.hits.size());
+        for (int i = 0; i < (int)state.hits.size(); i++) {
+            Body* body = lock.GetBody(i);
+            if (body == nullptr || !body->IsRigidBody() || !body->IsDynamic()) continue;
+            RVec3 position = body->GetCenterOfMassPosition();
+            if (!body->IsActive()) {
+                bool inside = false;
+                for (const ForceFieldDef& field : state.fields) {
+                    inside |= ForceFieldContains(field, (float)position.GetX(), (float)position.GetY(), (float)position.GetZ());
+                }
+                if (!inside) continue;
+            }
+            Vec3 velocity = body->GetLinearVelocity();
+            state.batch.Add((float)position.GetX(), (float)position.GetY(), (float)position.GetZ(),
+                            velocity.GetX(), velocity.GetY(), velocity.GetZ());
+            state.bodies.push_back(body);
+        }
+
+        ApplyFieldAccelerations(state.fields, state.batch);
+
+        Vec3 gravity = physicsSystem.GetGravity();
+        for (size_t i = 0; i < state.bodies.size(); i++) {
+            Body* body = state.bodies[i];
+            bool pushed = false;
+
+            Vec3 acceleration(state.batch.ax[i], state.batch.ay[i], state.batch.az[i]);
+            bool asleep = !body->IsActive();
+            if (asleep && acceleration.LengthSq() < kFieldWakeAcceleration * kFieldWakeAcceleration) continue;
+
+            float inverseMass = body->GetMotionProperties()->GetInverseMass();
+            if (!acceleration.IsNearZero() && inverseMass > 0.0f) {
+                body->AddForce(acceleration / inverseMass);
+                pushed = true;
+            }
 
-            // Launch ball forward with slight upward angle
-            bodyInterface.SetLinearVelocity(gBallId, Vec3(0.0f, 3.0f, -BALL_SPEED));
+            for (const ForceFieldDef& field : state.fields) {
+                if (field.type != ForceFieldType::Buoyancy) continue;
+                float min[3], max[3];
+                ForceFieldBounds(field, min, max);
+                const AABox& box = body->GetWorldSpaceBounds();
+                if (box.mMax.GetX() < min[0] || box.mMin.GetX() > max[0] || box.mMin.GetY() > max[1] ||
+                    box.mMax.GetY() < min[1] || box.mMax.GetZ() < min[2] || box.mMin.GetZ() > max[2]) continue;
+
+                Vec3 current(field.velocity[0], field.velocity[1], field.velocity[2]);
+                pushed |= body->ApplyBuoyancyImpulse(RVec3(field.center[0], max[1], field.center[2]), Vec3::sAxisY(),
+                    field.buoyancy, field.linearDrag, field.angularDrag, current, gravity, deltaTime);
+            }
+
+            if (!pushed) continue;
+            affected++;
+            if (asleep) state.toWake.push_back(body->GetID());
         }
+    }
+    if (!state.toWake.empty()) {
+        physicsSystem.GetBodyInterface().ActivateBodies(state.toWake.data(), (int)state.toWake.size());
+    }
+    return affected;
+}
+
+// Input buttons, one bit each, so sessions can be recorded and replayed
+namespace Buttons {
+    static constexpr uint32 Left = 1 << 0;
+    static constexpr uint32 Right = 1 << 1;
+    static constexpr uint32 Forward = 1 << 2;
+    static constexpr uint32 Back = 1 << 3;
+    static constexpr uint32 Launch = 1 << 4; // Pressed this tick
+    static constexpr uint32 Reset = 1 << 5;  // Pressed this tick
+    static constexpr uint32 Explode = 1 << 6; // Pressed this tick
+    static constexpr uint32 Movement = Left | Right | Forward | Back;
+};
+
+uint32 ReadButtons() {
+    uint32 buttons = 0;
+    if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT))  buttons |= Buttons::Left;
+    if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) buttons |= Buttons::Right;
+    if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP))    buttons |= Buttons::Forward;
+    if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN))  buttons |= Buttons::Back;
+    if (IsKeyPressed(KEY_SPACE)) buttons |= Buttons::Launch;
+    if (IsKeyPressed(KEY_R))     buttons |= Buttons::Reset;
+    if (IsKeyPressed(KEY_E))     buttons |= Buttons::Explode;
+    return buttons;
+}
+
+// Intro flyover: a wide shot of the arena settling into the play camera
+// behind the paddle, with titles and an optional sound cue
+CompiledCutscene MakeIntroCutscene(Vector3 paddlePos, const char* soundPath) {
+    Vector3 playPosition = { paddlePos.x, 12.0f, paddlePos.z + 15.0f };
+    Vector3 playTarget = { paddlePos.x, 2.0f, paddlePos.z - 5.0f };
+
+    vector<CutsceneCue> cues;
+    CutsceneCue sweep;
+    sweep.type = CueType::Camera;
+    sweep.time = 0.0f;
+    sweep.duration = 3.0f;
+    sweep.from = { -ARENA_WIDTH, 25.0f, -ARENA_DEPTH };
+    sweep.to = { ARENA_WIDTH, 18.0f, 0.0f };
+    sweep.lookFrom = { 0.0f, 0.0f, 0.0f };
+    sweep.lookTo = { 0.0f, 2.0f, -ARENA_DEPTH / 4 };
+    cues.push_back(sweep);
+
+    CutsceneCue settle;
+    settle.type = CueType::Camera;
+    settle.time = 3.0f;
+    settle.duration = 2.0f;
+    settle.from = sweep.to;
+    settle.to = playPosition;
+    settle.lookFrom = sweep.lookTo;
+    settle.lookTo = playTarget;
+    cues.push_back(settle);
+
+    CutsceneCue title;
+    title.type = CueType::Text;
+    title.time = 0.5f;
+    title.duration = 2.5f;
+    title.text = "3D TENNIS TARGET";
+    cues.push_back(title);
+
+    CutsceneCue hint;
+    hint.type = CueType::Text;
+    hint.time = 3.2f;
+    hint.duration = 1.6f;
+    hint.text = "Hit the targets before you run out of balls";
+    cues.push_back(hint);
+
+    if (soundPath != nullptr) {
+        CutsceneCue sound;
+        sound.type = CueType::Audio;
+        sound.time = 0.5f;
+        sound.asset = soundPath;
+        cues.push_back(sound);
+    }
+    return CompileCutscene(std::move(cues));
+}
+
+// Simulation state for one play session, independent of the window so it can
+// also run headless. Physics objects hold pointers into it, so it is heap
+// allocated once and never copied.
+struct Arena {
+    TempAllocatorImpl tempAllocator { 10 * 1024 * 1024 };
+    JobSystemThreadPool jobSystem;
+
+    BPLayerInterfaceImpl broadPhaseLayerInterface;
+    ObjectVsBroadPhaseLayerFilterImpl objectVsBroadphaseLayerFilter;
+    ObjectLayerPairFilterImpl objectVsObjectLayerFilter;
+    PhysicsSystem physicsSystem;
+    GameBodyActivationListener bodyActivationListener;
+    GameContactListener contactListener;
+
+    ScreenBodies screenBodies;
+    StaticWorld staticWorld;
+    BodyID paddleId;
+    PhysicsLod physicsLod;
+    BroadPhaseMaintenance broadPhaseMaintenance;
+    GameState gameState;
+    TargetBuildTimings targetBuild; // Of the level load
+    bool gameOver = false;
+
+    // Moving entities from the last physics update and their cached draw positions
+    MovingSet movingSet;
+    Vector3 paddlePos;
+    Vector3 paddleDrawPos;
+    Vector3 ballDrawPos;
+    vector<Vector3> chainDrawPos; // Indexed by chain link entity index
+    SoftBodySet softBodies;
+    ExplosionQueue explosions;
+    ForceFieldState forceFields;
+
+    // Cost attribution per entity type; table indices match EntityType
+    EntityCostTable entityCosts;
+    double lastPhysicsMs = 0.0; // PhysicsSystem::Update time of the last step
+};
+
+// Build the level. numThreads counts the calling thread, so 1 runs physics
+// jobs on the main thread only.
+void InitArena(Arena& arena, int numThreads, uint64 seed) {
+    arena.jobSystem.Init(cMaxPhysicsJobs, cMaxPhysicsBarriers, max(0, numThreads - 1));
 
-        // Reset game with R
-        if (IsKeyPressed(KEY_R)) {
-            gameState.score = 0;
-            gameState.ballsRemaining = 10;
+    // Physics configuration
+    const uint cMaxBodies = 1024;
+    const uint cNumBodyMutexes = 0;
+    const uint cMaxBodyPairs = 1024;
+    const uint cMaxContactConstraints = 1024;
+
+    // Create physics system
+    PhysicsSystem& physicsSystem = arena.physicsSystem;
+    physicsSystem.Init(cMaxBodies, cNumBodyMutexes, cMaxBodyPairs, cMaxContactConstraints,
+                       arena.broadPhaseLayerInterface, arena.objectVsBroadphaseLayerFilter, arena.objectVsObjectLayerFilter);
+
+    // Same inputs must give the same result regardless of thread count
+    PhysicsSettings physicsSettings = physicsSystem.GetPhysicsSettings();
+    physicsSettings.mDeterministicSimulation = true;
+    physicsSystem.SetPhysicsSettings(physicsSettings);
+
+    // Listeners
+    physicsSystem.SetBodyActivationListener(&arena.bodyActivationListener);
+    physicsSystem.SetContactListener(&arena.contactListener);
+
+    BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+    for (uint32 type = 0; type <= (uint32)EntityType::StaticRegion; type++) {
+        arena.entityCosts.AddType(GetEntityTypeName((EntityType)type));
+    }
+    gEntityCosts = &arena.entityCosts;
+
+    // Static arena geometry, merged into compound bodies below
+    vector<StaticPiece> staticPieces;
+
+    // Floor
+    BoxShapeSettings floorShapeSettings(Vec3(ARENA_WIDTH/2, 0.5f, ARENA_DEPTH/2));
+    floorShapeSettings.SetEmbedded();
+    ShapeRefC floorShape = floorShapeSettings.Create().Get();
+    staticPieces.push_back({ floorShape, RVec3(0.0_r, -0.5_r, 0.0_r), MakeEntityHandle(EntityType::Floor, 0) });
+
+    // Back wall
+    BoxShapeSettings backWallSettings(Vec3(ARENA_WIDTH/2, 5.0f, 0.5f));
+    backWallSettings.SetEmbedded();
+    ShapeRefC backWallShape = backWallSettings.Create().Get();
+    staticPieces.push_back({ backWallShape, RVec3(0.0_r, 5.0_r, -ARENA_DEPTH/2), MakeEntityHandle(EntityType::Wall, 0) });
+
+    // Side walls
+    BoxShapeSettings sideWallSettings(Vec3(0.5f, 5.0f, ARENA_DEPTH/2));
+    sideWallSettings.SetEmbedded();
+    ShapeRefC sideWallShape = sideWallSettings.Create().Get();
+    staticPieces.push_back({ sideWallShape, RVec3(-ARENA_WIDTH/2, 5.0_r, 0.0_r), MakeEntityHandle(EntityType::Wall, 1) });
+    staticPieces.push_back({ sideWallShape, RVec3(ARENA_WIDTH/2, 5.0_r, 0.0_r), MakeEntityHandle(EntityType::Wall, 2) });
+
+    // Bodies owned by this screen, torn down together on exit
+    BodyIDVector& levelBodies = GetBodyGroup(arena.screenBodies, BodyGroup::Level);
+
+    BuildStaticWorld(bodyInterface, staticPieces, arena.staticWorld);
+    gStaticWorld = &arena.staticWorld;
+    for (const StaticRegion& region : arena.staticWorld.regions) {
+        levelBodies.push_back(region.bodyId);
+    }
+
+    // Create paddle (kinematic - player controlled)
+    BoxShapeSettings paddleShapeSettings(Vec3(PADDLE_WIDTH/2, PADDLE_HEIGHT/2, PADDLE_DEPTH/2));
+    paddleShapeSettings.SetEmbedded();
+    ShapeRefC paddleShape = paddleShapeSettings.Create().Get();
+
+    Vector3 paddlePos = { 0.0f, 1.0f, ARENA_DEPTH/2 - 3.0f };
+    BodyCreationSettings paddleSettings(paddleShape, RVec3(paddlePos.x, paddlePos.y, paddlePos.z), Quat::sIdentity(), EMotionType::Kinematic, Layers::PADDLE);
+    paddleSettings.mUserData = MakeEntityHandle(EntityType::Paddle, 0);
+    Body* paddle = bodyInterface.CreateBody(paddleSettings);
+    bodyInterface.AddBody(paddle->GetID(), EActivation::Activate);
+    arena.paddleId = paddle->GetID();
+    levelBodies.push_back(arena.paddleId);
+
+    // Create ball (dynamic)
+    SphereShapeSettings ballShapeSettings(BALL_RADIUS);
+    ballShapeSettings.SetEmbedded();
+    ShapeRefC ballShape = ballShapeSettings.Create().Get();
+
+    Vector3 ballStartPos = { paddlePos.x, paddlePos.y + 1.0f, paddlePos.z - 1.0f };
+    BodyCreationSettings ballSettings(ballShape, RVec3(ballStartPos.x, ballStartPos.y, ballStartPos.z), Quat::sIdentity(), EMotionType::Dynamic, Layers::MOVING);
+    ballSettings.mRestitution = 0.8f;
+    ballSettings.mFriction = 0.2f;
+    ballSettings.mUserData = MakeEntityHandle(EntityType::Ball, 0);
+    Body* ball = bodyInterface.CreateBody(ballSettings);
+    bodyInterface.AddBody(ball->GetID(), EActivation::Activate);
+    gBallId = ball->GetID();
+    levelBodies.push_back(gBallId);
+
+    // Chain across the arena, anchored to both side walls
+    ChainDef chain;
+    chain.start = { -ARENA_WIDTH/2 + 0.5f, CHAIN_HEIGHT, CHAIN_Z };
+    chain.end = { ARENA_WIDTH/2 - 0.5f, CHAIN_HEIGHT, CHAIN_Z };
+    chain.links = CHAIN_LINKS;
+    chain.linkRadius = CHAIN_LINK_RADIUS;
+    chain.slack = 0.1f;
+    chain.jointType = JointType::Revolute;
+    chain.anchorStart = true;
+    chain.anchorEnd = true;
+    chain.solverSteps = 0;
+    BodyIDVector chainIds = BuildChain(physicsSystem, chain, 0, 0, levelBodies, arena.screenBodies.constraints);
+    RegisterLodGroup(arena.physicsLod, chainIds);
+    for (const JointPoint& p : LayoutChain(chain).linkPositions) {
+        arena.chainDrawPos.push_back({ p.x, p.y, p.z });
+    }
+
+    // Wind bowing the chain back toward the targets, a gravity well bending
+    // shots between the targets and a pool in the front left corner
+    ForceFieldDef wind = {};
+    wind.type = ForceFieldType::Wind;
+    wind.center[0] = 0.0f; wind.center[1] = CHAIN_HEIGHT; wind.center[2] = CHAIN_Z;
+    wind.halfExtent[0] = ARENA_WIDTH/2; wind.halfExtent[1] = 2.0f; wind.halfExtent[2] = 1.5f;
+    wind.velocity[2] = -4.0f;
+    wind.strength = 0.8f;
+    arena.forceFields.fields.push_back(wind);
+
+    ForceFieldDef well = {};
+    well.type = ForceFieldType::GravityWell;
+    well.center[0] = 0.0f; well.center[1] = 3.0f; well.center[2] = -ARENA_DEPTH/4 - 4.0f;
+    well.radius = 3.0f;
+    well.strength = 6.0f;
+    arena.forceFields.fields.push_back(well);
+
+    ForceFieldDef water = {};
+    water.type = ForceFieldType::Buoyancy;
+    water.center[0] = -ARENA_WIDTH/2 + 3.0f; water.center[1] = 0.75f; water.center[2] = 4.0f;
+    water.halfExtent[0] = 2.5f; water.halfExtent[1] = 0.75f; water.halfExtent[2] = 2.5f;
+    water.buoyancy = 1.6f;
+    water.linearDrag = 0.5f;
+    water.angularDrag = 0.05f;
+    arena.forceFields.fields.push_back(water);
+
+    // A flag on the left wall and a jelly block on the right
+    SoftBodyDesc flag = { SoftBodyKind::Cloth, 12, 2.5f, 0.0001f, true };
+    CreateSoftBodyEntity(bodyInterface, arena.softBodies, flag, RVec3(-ARENA_WIDTH/2 + 2.0f, 8.0f, -ARENA_DEPTH/2 + 1.5f), COLOR_RED, levelBodies);
+    SoftBodyDesc jelly = { SoftBodyKind::Jelly, 5, 1.5f, 0.0005f, false };
+    BodyID jellyId = CreateSoftBodyEntity(bodyInterface, arena.softBodies, jelly, RVec3(ARENA_WIDTH/2 - 3.0f, 1.0f, -2.0f), COLOR_GREEN, levelBodies);
+    if (!jellyId.IsInvalid()) RegisterLodGroup(arena.physicsLod, { jellyId });
+    for (SoftBodyEntity& entity : arena.softBodies.entities) {
+        ReadSoftBodyFrame(physicsSystem, entity, entity.frames[entity.front]);
+    }
+
+    // Game state
+    arena.gameState.random.Seed(seed);
+    gGameState = &arena.gameState;
+
+    // Create initial targets
+    ResetTargets(bodyInterface, arena.gameState, arena.screenBodies, arena.broadPhaseMaintenance, &arena.targetBuild);
+
+    // Optimize broad phase once the level is loaded
+    MaybeOptimizeBroadPhase(physicsSystem, arena.broadPhaseMaintenance, true);
+
+    arena.paddlePos = paddlePos;
+    arena.paddleDrawPos = paddlePos;
+    arena.ballDrawPos = ballStartPos;
+}
+
+// Advance gameplay and physics by one tick
+void StepArena(Arena& arena, uint32 buttons, float deltaTime) {
+    FrameProfiler& profiler = FrameProfiler::Get();
+    PhysicsSystem& physicsSystem = arena.physicsSystem;
+    BodyInterface& bodyInterface = physicsSystem.GetBodyInterface();
+    GameState& gameState = arena.gameState;
+    EntityCostTable& entityCosts = arena.entityCosts;
+    Vector3& paddlePos = arena.paddlePos;
+    StageTimer costTimer;
+    profiler.BeginZone("Gameplay");
+
+    // Input handling - paddle movement
+    float moveX = 0.0f;
+    float moveZ = 0.0f;
+
+    if (buttons & Buttons::Left)    moveX -= PADDLE_SPEED * deltaTime;
+    if (buttons & Buttons::Right)   moveX += PADDLE_SPEED * deltaTime;
+    if (buttons & Buttons::Forward) moveZ -= PADDLE_SPEED * deltaTime;
+    if (buttons & Buttons::Back)    moveZ += PADDLE_SPEED * deltaTime;
+
+    // Update paddle position
+    RVec3 currentPaddlePos = bodyInterface.GetPosition(arena.paddleId);
+    float newX = Clamp((float)currentPaddlePos.GetX() + moveX, -ARENA_WIDTH/2 + PADDLE_WIDTH, ARENA_WIDTH/2 - PADDLE_WIDTH);
+    float newZ = Clamp((float)currentPaddlePos.GetZ() + moveZ, 0.0f, ARENA_DEPTH/2 - 2.0f);
+    bodyInterface.SetPosition(arena.paddleId, RVec3(newX, currentPaddlePos.GetY(), newZ), EActivation::Activate);
+    paddlePos = { newX, (float)currentPaddlePos.GetY(), newZ };
+    entityCosts.AddTime((int)EntityType::Paddle, CostPhase::Update, costTimer.Lap());
+
+    // Launch ball with space
+    if ((buttons & Buttons::Launch) && !gameState.ballInPlay && gameState.ballsRemaining > 0) {
+        gameState.ballInPlay = true;
+        gameState.ballsRemaining--;
+
+        // Reset ball position above paddle
+        bodyInterface.SetPosition(gBallId, RVec3(paddlePos.x, paddlePos.y + 1.0f, paddlePos.z - 1.0f), EActivation::Activate);
+
+        // Launch ball forward with slight upward angle
+        bodyInterface.SetLinearVelocity(gBallId, Vec3(0.0f, 3.0f, -BALL_SPEED));
+    }
+    entityCosts.AddTime((int)EntityType::Ball, CostPhase::Update, costTimer.Lap());
+
+    // Detonate with E: the explode action if one was given, otherwise at the
+    // ball, or just ahead of the paddle while serving
+    if (buttons & Buttons::Explode && gExplodeAction != nullptr) {
+        QueueExplosion(arena.explosions, *gExplodeAction);
+    } else if (buttons & Buttons::Explode) {
+        RVec3 center = gameState.ballInPlay ? bodyInterface.GetPosition(gBallId)
+                                            : RVec3(paddlePos.x, paddlePos.y, paddlePos.z - 3.0f);
+        QueueExplosion(arena.explosions, { (float)center.GetX(), (float)center.GetY(), (float)center.GetZ(),
+                                           EXPLOSION_RADIUS, EXPLOSION_IMPULSE, ExplosionFalloff::Quadratic });
+    }
+
+    // Reset game with R
+    if (buttons & Buttons::Reset) {
+        gameState.score = 0;
+        gameState.ballsRemaining = 10;
+        gameState.ballInPlay = false;
+        arena.gameOver = false;
+
+        // Reset ball
+        bodyInterface.SetPosition(gBallId, RVec3(paddlePos.x, paddlePos.y + 1.0f, paddlePos.z - 1.0f), EActivation::Activate);
+        bodyInterface.SetLinearVelocity(gBallId, Vec3(0.0f, 0.0f, 0.0f));
+
+        // Reset targets
+        ResetTargets(bodyInterface, gameState, arena.screenBodies, arena.broadPhaseMaintenance);
+    }
+    entityCosts.AddTime((int)EntityType::Target, CostPhase::Update, costTimer.Lap());
+
+    // Check if ball is out of bounds (a sleeping ball can't leave the arena)
+    for (const MovingEntity& moving : arena.movingSet.entities) {
+        if (GetEntityType(moving.entity) != EntityType::Ball || !gameState.ballInPlay) continue;
+
+        RVec3 ballPos = moving.position;
+        if (ballPos.GetY() < -2.0f || ballPos.GetZ() > ARENA_DEPTH/2 + 5.0f ||
+            ballPos.GetZ() < -ARENA_DEPTH/2 - 5.0f ||
+            abs(ballPos.GetX()) > ARENA_WIDTH/2 + 5.0f) {
             gameState.ballInPlay = false;
-            gameOver = false;
 
-            // Reset ball
+            // Reset ball to paddle
             bodyInterface.SetPosition(gBallId, RVec3(paddlePos.x, paddlePos.y + 1.0f, paddlePos.z - 1.0f), EActivation::Activate);
             bodyInterface.SetLinearVelocity(gBallId, Vec3(0.0f, 0.0f, 0.0f));
 
-            // Reset targets
-            ResetTargets(bodyInterface, gameState);
+            if (gameState.ballsRemaining <= 0) {
+                arena.gameOver = true;
+            }
+        }
+    }
+    entityCosts.AddTime((int)EntityType::Ball, CostPhase::Update, costTimer.Lap());
+
+    // Check if all targets hit - respawn them
+    bool allHit = true;
+    for (const auto& target : gameState.targets) {
+        if (target.active) {
+            allHit = false;
+            break;
         }
+    }
+    if (allHit && !gameState.targets.empty()) {
+        ResetTargets(bodyInterface, gameState, arena.screenBodies, arena.broadPhaseMaintenance);
+    }
+    entityCosts.AddTime((int)EntityType::Target, CostPhase::Update, costTimer.Lap());
 
-        // Check if ball is out of bounds
-        RVec3 ballPos = bodyInterface.GetPosition(gBallId);
-        if (gameState.ballInPlay) {
-            if (ballPos.GetY() < -2.0f || ballPos.GetZ() > ARENA_DEPTH/2 + 5.0f ||
-                ballPos.GetZ() < -ARENA_DEPTH/2 - 5.0f ||
-                abs(ballPos.GetX()) > ARENA_WIDTH/2 + 5.0f) {
-                gameState.ballInPlay = false;
+    // Between serves nothing is in flight, so rebuild the broadphase if it has churned
+    if (!gameState.ballInPlay) {
+        MaybeOptimizeBroadPhase(physicsSystem, arena.broadPhaseMaintenance);
+    }
 
-                // Reset ball to paddle
-                bodyInterface.SetPosition(gBallId, RVec3(paddlePos.x, paddlePos.y + 1.0f, paddlePos.z - 1.0f), EActivation::Activate);
-                bodyInterface.SetLinearVelocity(gBallId, Vec3(0.0f, 0.0f, 0.0f));
+    profiler.EndZone();
+
+    // Freeze or wake distant dynamic bodies
+    profiler.BeginZone("PhysicsLod");
+    UpdatePhysicsLod(physicsSystem, arena.physicsLod, RVec3(paddlePos.x, paddlePos.y, paddlePos.z));
+    profiler.EndZone();
+
+    // Update physics, once last frame's soft body readback is out of the way
+    profiler.BeginZone("Physics");
+    costTimer.Lap();
+    FinishSoftBodyReadback(arena.jobSystem, arena.softBodies);
+    profiler.SetCounter("explosion_bodies", ApplyExplosions(physicsSystem, arena.explosions));
+    entityCosts.AddPhysicsTime(costTimer.Lap());
+    profiler.SetCounter("force_field_bodies", ApplyForceFields(physicsSystem, arena.forceFields, deltaTime));
+    entityCosts.AddTime((int)EntityType::ForceField, CostPhase::Update, costTimer.Lap());
+    const int cCollisionSteps = 1;
+    physicsSystem.Update(deltaTime, cCollisionSteps, &arena.tempAllocator, &arena.jobSystem);
+    double physicsMs = costTimer.Lap();
+    arena.lastPhysicsMs = physicsMs;
+    entityCosts.AddPhysicsTime(physicsMs);
+    static MetricHistogram& physicsStepMs = MetricsRegistry::Get().GetHistogram("physics_step_ms");
+    physicsStepMs.Record(physicsMs);
+    StartSoftBodyReadback(physicsSystem, arena.jobSystem, arena.softBodies);
+
+    // Score hits in target order, whatever order the physics threads found them in
+    ApplyTargetHits(arena.contactListener, gameState);
+
+    // Collect what moved and refresh cached draw positions
+    BuildMovingSet(physicsSystem, arena.bodyActivationListener, arena.movingSet);
+    for (const MovingEntity& moving : arena.movingSet.entities) {
+        entityCosts.AddActiveBodies((int)GetEntityType(moving.entity));
+        switch (GetEntityType(moving.entity)) {
+        case EntityType::Paddle: arena.paddleDrawPos = JoltToRaylib(moving.position); break;
+        case EntityType::Ball:   arena.ballDrawPos = JoltToRaylib(moving.position); break;
+        case EntityType::ChainLink: {
+            uint32 link = GetEntityIndex(moving.entity);
+            if (link < arena.chainDrawPos.size()) arena.chainDrawPos[link] = JoltToRaylib(moving.position);
+            break;
+        }
+        default: break;
+        }
+    }
+    profiler.EndZone();
+
+    profiler.SetCounter("bodies", physicsSystem.GetNumBodies());
+    profiler.SetCounter("active_bodies", physicsSystem.GetNumActiveBodies(EBodyType::RigidBody));
+    profiler.SetCounter("active_soft_bodies", physicsSystem.GetNumActiveBodies(EBodyType::SoftBody));
+    profiler.SetCounter("moving_entities", (double)arena.movingSet.entities.size());
+
+    static MetricGauge& bodyCount = MetricsRegistry::Get().GetGauge("bodies");
+    static MetricGauge& activeBodyCount = MetricsRegistry::Get().GetGauge("active_bodies");
+    static MetricGauge& movingEntityCount = MetricsRegistry::Get().GetGauge("moving_entities");
+    static MetricGauge& score = MetricsRegistry::Get().GetGauge("score");
+    bodyCount.Set(physicsSystem.GetNumBodies());
+    activeBodyCount.Set(physicsSystem.GetNumActiveBodies(EBodyType::RigidBody));
+    movingEntityCount.Set((double)arena.movingSet.entities.size());
+    score.Set(gameState.score);
+}
 
-                if (gameState.ballsRemaining <= 0) {
-                    gameOver = true;
-                }
+void ShutdownArena(Arena& arena) {
+    ShutdownSoftBodies(arena.jobSystem, arena.softBodies);
+    TeardownScreen(arena.physicsSystem, arena.screenBodies);
+    gEntityCosts = nullptr;
+    gGameState = nullptr;
+    gStaticWorld = nullptr;
+}
+
+// Determinism harness
+// Hash every body's full state (in body ID order, which is reproducible since
+// IDs are handed out in a fixed order) plus the scoring state
+void HashArena(Arena& arena, DeterminismTrace& trace) {
+    BodyIDVector bodyIds;
+    arena.physicsSystem.GetBodies(bodyIds);
+
+    vector<BodyHash> bodies;
+    bodies.reserve(bodyIds.size());
+    BodyLockMultiRead lock(arena.physicsSystem.GetBodyLockInterface(), bodyIds.data(), (int)bodyIds.size());
+    for (int i = 0; i < (int)bodyIds.size(); i++) {
+        const Body* body = lock.GetBody(i);
+        if (body == nullptr) continue;
+
+        RVec3 position = body->GetPosition();
+        Quat rotation = body->GetRotation();
+        Vec3 linearVelocity = body->GetLinearVelocity();
+        Vec3 angularVelocity = body->GetAngularVelocity();
+
+        StateHasher hasher;
+        hasher.Add(position.GetX());
+        hasher.Add(position.GetY());
+        hasher.Add(position.GetZ());
+        hasher.Add(rotation.GetX());
+        hasher.Add(rotation.GetY());
+        hasher.Add(rotation.GetZ());
+        hasher.Add(rotation.GetW());
+        hasher.Add(linearVelocity.GetX());
+        hasher.Add(linearVelocity.GetY());
+        hasher.Add(linearVelocity.GetZ());
+        hasher.Add(angularVelocity.GetX());
+        hasher.Add(angularVelocity.GetY());
+        hasher.Add(angularVelocity.GetZ());
+        hasher.Add(body->IsActive());
+        if (body->IsSoftBody()) {
+            const SoftBodyMotionProperties* motion = static_cast<const SoftBodyMotionProperties*>(body->GetMotionProperties());
+            for (const SoftBodyVertex& vertex : motion->GetVertices()) {
+                hasher.Add(vertex.mPosition.GetX());
+                hasher.Add(vertex.mPosition.GetY());
+                hasher.Add(vertex.mPosition.GetZ());
             }
         }
+        bodies.push_back({ body->GetUserData(), hasher.Get() });
+    }
 
-        // Check if all targets hit - respawn them
-        bool allHit = true;
-        for (const auto& target : gameState.targets) {
-            if (target.active) {
-                allHit = false;
-                break;
+    const GameState& gameState = arena.gameState;
+    StateHasher game;
+    game.Add(gameState.score);
+    game.Add(gameState.ballsRemaining);
+    game.Add(gameState.ballInPlay);
+    game.Add(arena.gameOver);
+    for (const Target& target : gameState.targets) {
+        game.Add(target.active);
+    }
+    trace.RecordTick(std::move(bodies), game.Get());
+}
+
+string DescribeEntity(uint64 handle) {
+    return string(GetEntityTypeName(GetEntityType(handle))) + " #" + to_string(GetEntityIndex(handle));
+}
+
+// Replay keyframes
+// A snapshot is Jolt's full physics state followed by the game state the next
+// tick reads, DEFLATE-compressed. It is only valid for an arena built from the
+// same session seed, since Jolt restores into existing bodies by ID. Soft body
+// draw buffers aren't included; the next tick's readback refills them.
+const float KEYFRAME_INTERVAL = 10.0f; // Seconds between keyframes while recording
+
+int KeyframeTicks(float dt) {
+    return max(1, (int)lroundf(KEYFRAME_INTERVAL / dt));
+}
+
+void SaveArenaSnapshot(Arena& arena, vector<unsigned char>& out) {
+    // The readback jobs lock bodies, so let them finish first
+    FinishSoftBodyReadback(arena.jobSystem, arena.softBodies);
+
+    StateRecorderImpl recorder;
+    arena.physicsSystem.SaveState(recorder, EStateRecorderState::All);
+
+    const GameState& gameState = arena.gameState;
+    recorder.Write(gameState.score);
+    recorder.Write(gameState.ballsRemaining);
+    recorder.Write(gameState.ballInPlay);
+    recorder.Write(gameState.random.GetState());
+    recorder.Write(gameState.targets.size());
+    for (const Target& target : gameState.targets) {
+        recorder.Write(target.bodyId.GetIndexAndSequenceNumber());
+        recorder.Write(target.position);
+        recorder.Write(target.color);
+        recorder.Write(target.points);
+        recorder.Write(target.active);
+    }
+
+    recorder.Write(arena.gameOver);
+    recorder.Write(arena.paddlePos);
+    recorder.Write(arena.paddleDrawPos);
+    recorder.Write(arena.ballDrawPos);
+    recorder.Write(arena.chainDrawPos.size());
+    for (const Vector3& position : arena.chainDrawPos) recorder.Write(position);
+
+    // The next tick's out of bounds check reads last tick's moving set
+    recorder.Write(arena.movingSet.entities.size());
+    for (const MovingEntity& moving : arena.movingSet.entities) {
+        recorder.Write(moving.bodyId.GetIndexAndSequenceNumber());
+        recorder.Write(moving.entity);
+        recorder.Write(moving.position);
+    }
+
+    recorder.Write(arena.physicsLod.cursor);
+    recorder.Write(arena.physicsLod.groups.size());
+    for (const LodGroup& group : arena.physicsLod.groups) {
+        recorder.Write(group.frozen);
+        for (size_t i = 0; i < group.bodyIds.size(); i++) {
+            recorder.Write(group.linearVelocities[i]);
+            recorder.Write(group.angularVelocities[i]);
+        }
+    }
+    recorder.Write(arena.broadPhaseMaintenance.bodiesAdded);
+    recorder.Write(arena.broadPhaseMaintenance.bodiesRemoved);
+
+    string data = recorder.GetData();
+    int compressedSize = 0;
+    unsigned char* compressed = CompressData((const unsigned char*)data.data(), (int)data.size(), &compressedSize);
+    out.assign(compressed, compressed + compressedSize);
+    MemFree(compressed);
+}
+
+bool RestoreArenaSnapshot(Arena& arena, const vector<unsigned char>& snapshot) {
+    int size = 0;
+    unsigned char* data = DecompressData(snapshot.data(), (int)snapshot.size(), &size);
+    if (data == nullptr) return false;
+    StateRecorderImpl recorder;
+    recorder.WriteBytes(data, size);
+    MemFree(data);
+
+    FinishSoftBodyReadback(arena.jobSystem, arena.softBodies);
+    if (!arena.physicsSystem.RestoreState(recorder)) return false;
+
+    GameState& gameState = arena.gameState;
+    uint64_t randomState = 0;
+    size_t count = 0;
+    recorder.Read(gameState.score);
+    recorder.Read(gameState.ballsRemaining);
+    recorder.Read(gameState.ballInPlay);
+    recorder.Read(randomState);
+    gameState.random.SetState(randomState);
+    recorder.Read(count);
+    if (count != gameState.targets.size()) return false;
+    for (Target& target : gameState.targets) {
+        uint32 bodyId = 0;
+        recorder.Read(bodyId);
+        if (bodyId != target.bodyId.GetIndexAndSequenceNumber()) return false;
+        recorder.Read(target.position);
+        recorder.Read(target.color);
+        recorder.Read(target.points);
+        recorder.Read(target.active);
+    }
+
+    recorder.Read(arena.gameOver);
+    recorder.Read(arena.paddlePos);
+    recorder.Read(arena.paddleDrawPos);
+    recorder.Read(arena.ballDrawPos);
+    recorder.Read(count);
+    if (count != arena.chainDrawPos.size()) return false;
+    for (Vector3& position : arena.chainDrawPos) recorder.Read(position);
+
+    recorder.Read(count);
+    arena.movingSet.entities.resize(count);
+    for (MovingEntity& moving : arena.movingSet.entities) {
+        uint32 bodyId = 0;
+        recorder.Read(bodyId);
+        moving.bodyId = BodyID(bodyId);
+        recorder.Read(moving.entity);
+        recorder.Read(moving.position);
+    }
+
+    recorder.Read(arena.physicsLod.cursor);
+    recorder.Read(count);
+    if (count != arena.physicsLod.groups.size()) return false;
+    for (LodGroup& group : arena.physicsLod.groups) {
+        recorder.Read(group.frozen);
+        for (size_t i = 0; i < group.bodyIds.size(); i++) {
+            recorder.Read(group.linearVelocities[i]);
+            recorder.Read(group.angularVelocities[i]);
+        }
+    }
+    recorder.Read(arena.broadPhaseMaintenance.bodiesAdded);
+    recorder.Read(arena.broadPhaseMaintenance.bodiesRemoved);
+
+    // Restoring activates and deactivates bodies; those aren't real events
+    BodyIDVector restoredActivity;
+    arena.bodyActivationListener.TakeDeactivated(restoredActivity);
+    return !recorder.IsFailed();
+}
+
+// Replay a session headlessly with the given physics thread count
+void RunSession(const Session& session, int numThreads, DeterminismTrace& trace) {
+    unique_ptr<Arena> arena = make_unique<Arena>();
+    InitArena(*arena, numThreads, session.seed);
+
+    for (const SessionTick& tick : session.ticks) {
+        arena->entityCosts.BeginFrame();
+        StepArena(*arena, tick.buttons, tick.dt);
+        arena->entityCosts.EndFrame();
+        HashArena(*arena, trace);
+    }
+
+    ShutdownArena(*arena);
+}
+
+// Seek to a tick the way a viewer would: restore the nearest keyframe and
+// simulate the rest. The result is checked against a straight replay from
+// tick 0, which also records keyframes if the session came without any.
+int SeekSession(Session& session, int tick, int numThreads) {
+    tick = Clamp(tick, 0, (int)session.ticks.size());
+    const int keyframeTicks = KeyframeTicks(session.ticks.empty() ? 1.0f / 60.0f : session.ticks[0].dt);
+    bool recordKeyframes = session.keyframes.empty();
+
+    DeterminismTrace reference;
+    reference.label = "replay from tick 0";
+    auto start = chrono::steady_clock::now();
+    {
+        unique_ptr<Arena> arena = make_unique<Arena>();
+        InitArena(*arena, numThreads, session.seed);
+        for (int t = 0; t < tick; t++) {
+            if (recordKeyframes && t > 0 && t % keyframeTicks == 0) {
+                session.keyframes.push_back({ (uint32_t)t, {} });
+                SaveArenaSnapshot(*arena, session.keyframes.back().data);
             }
+            arena->entityCosts.BeginFrame();
+            StepArena(*arena, session.ticks[t].buttons, session.ticks[t].dt);
+            arena->entityCosts.EndFrame();
         }
-        if (allHit && !gameState.targets.empty()) {
-            ResetTargets(bodyInterface, gameState);
+        HashArena(*arena, reference);
+        ShutdownArena(*arena);
+    }
+    double replayMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    if (recordKeyframes) cout << "Session had no keyframes; recorded " << session.keyframes.size() << " while replaying" << endl;
+
+    DeterminismTrace seek;
+    seek.label = "seek";
+    start = chrono::steady_clock::now();
+    unique_ptr<Arena> arena = make_unique<Arena>();
+    InitArena(*arena, numThreads, session.seed);
+    double initMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    const SessionKeyframe* keyframe = session.FindKeyframe((uint32_t)tick);
+    int firstTick = 0;
+    if (keyframe != nullptr) {
+        if (!RestoreArenaSnapshot(*arena, keyframe->data)) {
+            cout << "Failed to restore the keyframe at tick " << keyframe->tick << endl;
+            ShutdownArena(*arena);
+            return 2;
         }
+        firstTick = (int)keyframe->tick;
+    }
+    double restoreMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() - initMs;
+
+    for (int t = firstTick; t < tick; t++) {
+        arena->entityCosts.BeginFrame();
+        StepArena(*arena, session.ticks[t].buttons, session.ticks[t].dt);
+        arena->entityCosts.EndFrame();
+    }
+    double seekMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    HashArena(*arena, seek);
+    ShutdownArena(*arena);
+
+    printf("Seek to tick %d: keyframe at tick %d (%zu bytes), init %.1f ms, restore %.2f ms, %d ticks resimulated\n",
+        tick, firstTick, keyframe != nullptr ? keyframe->data.size() : (size_t)0, initMs, restoreMs, tick - firstTick);
+    printf("Time to seek %.1f ms, replay from tick 0 %.1f ms\n", seekMs, replayMs);
+    return ReportDeterminism(reference, seek, DescribeEntity) ? 0 : 1;
+}
+
+double MedianOf(vector<double> values) {
+    if (values.empty()) return 0.0;
+    size_t middle = values.size() / 2;
+    nth_element(values.begin(), values.begin() + middle, values.end());
+    return values[middle];
+}
 
-        // Update physics
-        const int cCollisionSteps = 1;
-        physicsSystem.Update(deltaTime, cCollisionSteps, &tempAllocator, &jobSystem);
+// Replay the scripted session headlessly several times, each trial in a fresh
+// arena, and save one sample per trial for bench_compare. Per-tick times are
+// reduced to their median within a trial so a single hitch doesn't dominate.
+int RunBenchmarkTrials(const Session& session, int numThreads, int trials, const char* outPath) {
+    BenchResults results;
+    results.name = "demo_3d";
+    cout << "Benchmark: " << trials << " trials of " << session.ticks.size() << " ticks, " << numThreads << " threads" << endl;
+
+    for (int trial = 0; trial < trials; trial++) {
+        unique_ptr<Arena> arena = make_unique<Arena>();
+        auto loadStart = chrono::steady_clock::now();
+        InitArena(*arena, numThreads, session.seed);
+        double loadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count();
+
+        vector<double> tickMs, stepMs;
+        tickMs.reserve(session.ticks.size());
+        stepMs.reserve(session.ticks.size());
+        double peakHeapMb = 0.0;
+        for (const SessionTick& tick : session.ticks) {
+            auto tickStart = chrono::steady_clock::now();
+            arena->entityCosts.BeginFrame();
+            StepArena(*arena, tick.buttons, tick.dt);
+            arena->entityCosts.EndFrame();
+            tickMs.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - tickStart).count());
+            stepMs.push_back(arena->lastPhysicsMs);
+#ifdef __GLIBC__
+            peakHeapMb = max(peakHeapMb, mallinfo2().uordblks / (1024.0 * 1024.0));
+#endif
+        }
+        ShutdownArena(*arena);
+
+        results.Samples("frame_ms").push_back(MedianOf(tickMs));
+        results.Samples("step_ms").push_back(MedianOf(stepMs));
+        results.Samples("load_ms").push_back(loadMs);
+#ifdef __GLIBC__
+        results.Samples("memory_mb").push_back(peakHeapMb);
+#endif
+        printf("  trial %2d: frame %.3f ms  step %.3f ms  load %.2f ms  heap %.1f MB\n", trial + 1,
+            results.Samples("frame_ms").back(), results.Samples("step_ms").back(), loadMs, peakHeapMb);
+    }
 
-        // Update camera to follow paddle (third person)
-        camera.target = { paddlePos.x, 2.0f, paddlePos.z - 5.0f };
-        camera.position = { paddlePos.x, 12.0f, paddlePos.z + 15.0f };
+    if (!SaveBenchResults(results, outPath)) {
+        cout << "Failed to write " << outPath << endl;
+        return 2;
+    }
+    cout << "Benchmark results written to " << outPath << endl;
+    return 0;
+}
+
+// Replay the session once per thread count and compare every run against the
+// first. The first run's trace can be saved for comparing builds (e.g. -O2 vs
+// PGO), and compared against a trace saved by another build.
+int VerifyDeterminism(const Session& session, const vector<int>& threadCounts, const char* traceOutPath, const char* compareTracePath) {
+#ifdef JPH_CROSS_PLATFORM_DETERMINISTIC
+    cout << "Verifying determinism over " << session.ticks.size() << " ticks (cross-platform deterministic Jolt)" << endl;
+#else
+    cout << "Verifying determinism over " << session.ticks.size() << " ticks" << endl;
+#endif
+
+    vector<DeterminismTrace> traces;
+    for (int numThreads : threadCounts) {
+        DeterminismTrace trace;
+        trace.label = to_string(numThreads) + (numThreads == 1 ? " thread" : " threads");
+        RunSession(session, numThreads, trace);
+        traces.push_back(std::move(trace));
+    }
+
+    bool match = true;
+    for (size_t i = 1; i < traces.size(); i++) {
+        match &= ReportDeterminism(traces[0], traces[i], DescribeEntity);
+    }
+
+    if (traceOutPath != nullptr) {
+        if (SaveTrace(traces[0], traceOutPath)) {
+            cout << "Trace written to " << traceOutPath << endl;
+        } else {
+            cout << "Failed to write trace " << traceOutPath << endl;
+            match = false;
+        }
+    }
+
+    if (compareTracePath != nullptr) {
+        DeterminismTrace other;
+        if (LoadTrace(compareTracePath, other)) {
+            match &= ReportDeterminism(other, traces[0], DescribeEntity);
+        } else {
+            cout << "Failed to read trace " << compareTracePath << endl;
+            match = false;
+        }
+    }
+
+    cout << (match ? "Deterministic" : "NOT deterministic") << endl;
+    return match ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    // Command line
+    //   --record <session>              record inputs while playing
+    //   --verify-determinism [session]  replay headless (a scripted session if none is given)
+    //   --threads <n,n,...>             thread counts to compare (default 1,2,4,32)
+    //   --ticks <n>                     length of the scripted session (default 3600)
+    //   --trace-out <file>              save the hash trace for comparing builds
+    //   --compare-trace <file>          compare against a trace saved by another build
+    //   --bench-chain [links]           time building and stepping a chain (default 10000 links),
+    //                                   and stepping rows of chains with physics LOD
+    //   --capture <file>                record the window (.y4m video, otherwise numbered PNGs)
+    //   --intro [sound]                 play the intro cutscene first, with an optional sound cue
+    //   --seek <session> [tick]         restore the nearest keyframe, simulate to the tick (default
+    //                                   the last) and report the time to seek
+    //   --bench <file>                  run the scripted session --trials times (default 10) and
+    //                                   save per-trial timings for bench_compare (600 ticks unless --ticks)
+    //   --explode <x>,<y>,<z>,<radius>,<impulse>[,<falloff>]
+    //                                   explode action fired by E, in place of the blast at the
+    //                                   ball; pass it again when replaying a session recorded with it
+    const char* recordPath = nullptr;
+    const char* capturePath = nullptr;
+    const char* sessionPath = nullptr;
+    const char* traceOutPath = nullptr;
+    const char* compareTracePath = nullptr;
+    bool verifyDeterminism = false;
+    vector<int> threadCounts = { 1, 2, 4, 32 };
+    int scriptedTicks = 3600;
+    int benchChainLinks = 0;
+    const char* benchPath = nullptr;
+    bool playIntro = false;
+    const char* seekSessionPath = nullptr;
+    int seekTick = -1;
+    const char* introSoundPath = nullptr;
+    int benchTrials = 10;
+    bool ticksGiven = false;
+    bool threadsGiven = false;
+    ExplosionDef explodeAction;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc && argv[i + 1][0] != '-';
+        if (arg == "--record" && hasValue) recordPath = argv[++i];
+        else if (arg == "--explode" && i + 1 < argc) {
+            // Coordinates may be negative, so the value can start with '-'
+            if (!ParseExplodeAction(argv[++i], true, explodeAction)) {
+                cout << "Bad explode action: " << argv[i] << endl;
+                return 2;
+            }
+            gExplodeAction = &explodeAction;
+        }
+        else if (arg == "--capture" && hasValue) capturePath = argv[++i];
+        else if (arg == "--verify-determinism") {
+            verifyDeterminism = true;
+            if (hasValue) sessionPath = argv[++i];
+        }
+        else if (arg == "--threads" && hasValue) {
+            threadCounts = ParseThreadCounts(argv[++i]);
+            threadsGiven = true;
+        }
+        else if (arg == "--bench-chain") benchChainLinks = hasValue ? atoi(argv[++i]) : 10000;
+        else if (arg == "--bench" && hasValue) benchPath = argv[++i];
+        else if (arg == "--seek" && hasValue) {
+            seekSessionPath = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-') seekTick = atoi(argv[++i]);
+        }
+        else if (arg == "--intro") {
+            playIntro = true;
+            if (hasValue) introSoundPath = argv[++i];
+        }
+        else if (arg == "--trials" && hasValue) benchTrials = max(1, atoi(argv[++i]));
+        else if (arg == "--ticks" && hasValue) {
+            scriptedTicks = atoi(argv[++i]);
+            ticksGiven = true;
+        }
+        else if (arg == "--trace-out" && hasValue) traceOutPath = argv[++i];
+        else if (arg == "--compare-trace" && hasValue) compareTracePath = argv[++i];
+        else {
+            cout << "Unknown argument: " << arg << endl;
+            return 2;
+        }
+    }
+
+    // Soak test metrics, if LEVELFORGE_METRICS is set. Started before the
+    // headless modes so soak runs export too, and flushed on every return.
+    ScopedMetrics metrics;
+
+    const float deltaTime = 1.0f / 60.0f;
+
+    // Initialize Jolt
+    RegisterDefaultAllocator();
+#ifdef LEVELFORGE_ALLOC_TRACKING
+    InstallAllocTracker();
+    JPH::Allocate = TrackedJoltAllocate;
+    JPH::Reallocate = TrackedJoltReallocate;
+    JPH::Free = TrackedJoltFree;
+    JPH::AlignedAllocate = TrackedJoltAlignedAllocate;
+    JPH::AlignedFree = TrackedJoltAlignedFree;
+#endif
+    Trace = TraceImpl;
+    JPH_IF_ENABLE_ASSERTS(AssertFailed = AssertFailedImpl;)
+    Factory::sInstance = new Factory();
+    RegisterTypes();
+
+    if (benchChainLinks > 0) {
+        if (!threadsGiven || threadCounts.empty()) threadCounts = { (int)thread::hardware_concurrency() };
+        int result = BenchmarkChains(benchChainLinks, threadCounts, 300);
+
+        UnregisterTypes();
+        delete Factory::sInstance;
+        Factory::sInstance = nullptr;
+        return result;
+    }
+
+    if (benchPath != nullptr) {
+        int numThreads = threadsGiven && !threadCounts.empty() ? threadCounts[0] : (int)thread::hardware_concurrency();
+        Session session = MakeScriptedSession(1234, ticksGiven ? scriptedTicks : 600, deltaTime, Buttons::Movement, Buttons::Launch | Buttons::Reset | Buttons::Explode);
+        int result = RunBenchmarkTrials(session, numThreads, benchTrials, benchPath);
+
+        UnregisterTypes();
+        delete Factory::sInstance;
+        Factory::sInstance = nullptr;
+        return result;
+    }
+
+    if (seekSessionPath != nullptr) {
+        Session session;
+        if (!LoadSession(seekSessionPath, session)) {
+            cout << "Failed to read session " << seekSessionPath << endl;
+            return 2;
+        }
+        int numThreads = threadsGiven && !threadCounts.empty() ? threadCounts[0] : (int)thread::hardware_concurrency();
+        int result = SeekSession(session, seekTick >= 0 ? seekTick : (int)session.ticks.size(), numThreads);
+
+        UnregisterTypes();
+        delete Factory::sInstance;
+        Factory::sInstance = nullptr;
+        return result;
+    }
+
+    if (verifyDeterminism) {
+        Session session;
+        if (sessionPath == nullptr) {
+            session = MakeScriptedSession(1234, scriptedTicks, deltaTime, Buttons::Movement, Buttons::Launch | Buttons::Reset | Buttons::Explode);
+        } else if (!LoadSession(sessionPath, session)) {
+            cout << "Failed to read session " << sessionPath << endl;
+            return 2;
+        }
+        if (threadCounts.empty()) threadCounts.push_back(1);
+
+        int result = VerifyDeterminism(session, threadCounts, traceOutPath, compareTracePath);
+
+        UnregisterTypes();
+        delete Factory::sInstance;
+        Factory::sInstance = nullptr;
+        return result;
+    }
+
+    // Initialize raylib
+    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "3D Tennis Target Demo - Raylib + Jolt Physics");
+    SetTargetFPS(60);
+
+    // Every session is recorded in memory and saved on exit with --record
+    Session session;
+    session.seed = (uint64)time(nullptr);
+
+    unique_ptr<Arena> arenaOwner = make_unique<Arena>();
+    Arena& arena = *arenaOwner;
+    InitArena(arena, (int)thread::hardware_concurrency(), session.seed);
+    ReportTargetBuild(arena.targetBuild);
+    GameState& gameState = arena.gameState;
+    EntityCostTable& entityCosts = arena.entityCosts;
+
+    // Camera setup - third person
+    Camera3D camera = { 0 };
+    camera.position = { 0.0f, 15.0f, 25.0f };
+    camera.target = { 0.0f, 2.0f, 0.0f };
+    camera.up = { 0.0f, 1.0f, 0.0f };
+    camera.fovy = 45.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    // Dump a trace of the last few seconds whenever a frame takes over 50 ms
+    ConfigureHitchRecorder(60, 50.0);
+    FrameProfiler& profiler = FrameProfiler::Get();
+#ifdef LEVELFORGE_ALLOC_TRACKING
+    uint64_t lastAllocCount = GetAllocStats().allocCount;
+#endif
+    bool showEntityCosts = false;
+
+    // Soft body meshes, refreshed from each body's front buffer every frame
+    vector<Mesh> softBodyMeshes;
+    for (const SoftBodyEntity& entity : arena.softBodies.entities) {
+        softBodyMeshes.push_back(CreateSoftBodyMesh(entity));
+    }
+    Material softBodyMaterial = LoadMaterialDefault();
+
+    FrameCapture capture;
+    if (capturePath != nullptr && !capture.Start(capturePath, 60)) {
+        cout << "Can't capture to " << capturePath << endl;
+    }
+
+    // Input is ignored while the intro plays; SPACE or ENTER skips it
+    if (introSoundPath != nullptr) InitAudioDevice();
+    CompiledCutscene intro = MakeIntroCutscene(arena.paddlePos, introSoundPath);
+    CutscenePlayer cutscene;
+    if (playIntro) cutscene.Start(intro);
+
+    // Main game loop
+    while (!WindowShouldClose()) {
+        profiler.BeginFrame();
+        entityCosts.BeginFrame();
+
+        uint32 buttons = ReadButtons();
+        if (cutscene.IsPlaying()) {
+            if (IsKeyPressed(KEY_SPACE) || IsKeyPressed(KEY_ENTER)) cutscene.Skip();
+            else cutscene.Update(deltaTime);
+            buttons = 0;
+        }
+        if (recordPath != nullptr) {
+            // Keyframes so the recording can be seeked without replaying from the start
+            if (!session.ticks.empty() && session.ticks.size() % KeyframeTicks(deltaTime) == 0) {
+                profiler.BeginZone("Keyframe");
+                session.keyframes.push_back({ (uint32_t)session.ticks.size(), {} });
+                SaveArenaSnapshot(arena, session.keyframes.back().data);
+                profiler.EndZone();
+            }
+            session.ticks.push_back({ buttons, deltaTime });
+        }
+        StepArena(arena, buttons, deltaTime);
+
+        if (IsKeyPressed(KEY_F2)) showEntityCosts = !showEntityCosts;
+
+#ifdef LEVELFORGE_ALLOC_TRACKING
+        AllocStats allocStats = GetAllocStats();
+        profiler.SetCounter("allocs", (double)(allocStats.allocCount - lastAllocCount));
+        profiler.SetCounter("tracked_live_bytes", (double)allocStats.liveBytes);
+        lastAllocCount = allocStats.allocCount;
+#endif
+
+        // Update camera to follow paddle (third person), unless the intro has it
+        if (!cutscene.GetCamera(camera.position, camera.target)) {
+            camera.target = { arena.paddlePos.x, 2.0f, arena.paddlePos.z - 5.0f };
+            camera.position = { arena.paddlePos.x, 12.0f, arena.paddlePos.z + 15.0f };
+        }
 
         // Drawing
+        profiler.BeginZone("Render");
+        StageTimer costTimer;
         BeginDrawing();
         ClearBackground(COLOR_BG);
 
         BeginMode3D(camera);
+        costTimer.Lap();
 
         // Draw floor
         DrawPlane({ 0.0f, 0.0f, 0.0f }, { ARENA_WIDTH, ARENA_DEPTH }, COLOR_FLOOR);
+        int gridLines = 0;
 
         // Draw floor grid lines
         for (float x = -ARENA_WIDTH/2; x <= ARENA_WIDTH/2; x += 2.0f) {
             DrawLine3D({ x, 0.01f, -ARENA_DEPTH/2 }, { x, 0.01f, ARENA_DEPTH/2 }, COLOR_WHITE);
+            gridLines++;
         }
         for (float z = -ARENA_DEPTH/2; z <= ARENA_DEPTH/2; z += 2.0f) {
             DrawLine3D({ -ARENA_WIDTH/2, 0.01f, z }, { ARENA_WIDTH/2, 0.01f, z }, COLOR_WHITE);
+            gridLines++;
         }
+        entityCosts.AddDraw((int)EntityType::Floor, 1 + gridLines, PLANE_TRIANGLES);
+        entityCosts.AddTime((int)EntityType::Floor, CostPhase::Render, costTimer.Lap());
 
         // Draw walls (semi-transparent)
         DrawCubeV({ 0.0f, 5.0f, -ARENA_DEPTH/2 }, { ARENA_WIDTH, 10.0f, 1.0f }, COLOR_WALL);
@@ -504,26 +2832,76 @@ int main(void) {
         DrawCubeWiresV({ -ARENA_WIDTH/2, 5.0f, 0.0f }, { 1.0f, 10.0f, ARENA_DEPTH }, COLOR_BLUE);
         DrawCubeV({ ARENA_WIDTH/2, 5.0f, 0.0f }, { 1.0f, 10.0f, ARENA_DEPTH }, COLOR_WALL);
         DrawCubeWiresV({ ARENA_WIDTH/2, 5.0f, 0.0f }, { 1.0f, 10.0f, ARENA_DEPTH }, COLOR_BLUE);
+        entityCosts.AddDraw((int)EntityType::Wall, 6, 3 * CUBE_TRIANGLES);
+        entityCosts.AddTime((int)EntityType::Wall, CostPhase::Render, costTimer.Lap());
 
         // Draw paddle
-        RVec3 pPos = bodyInterface.GetPosition(paddleId);
-        Vector3 paddleDrawPos = JoltToRaylib(pPos);
-        DrawCubeV(paddleDrawPos, { PADDLE_WIDTH, PADDLE_HEIGHT, PADDLE_DEPTH }, COLOR_SKYBLUE);
-        DrawCubeWiresV(paddleDrawPos, { PADDLE_WIDTH, PADDLE_HEIGHT, PADDLE_DEPTH }, COLOR_DARKBLUE);
+        DrawCubeV(arena.paddleDrawPos, { PADDLE_WIDTH, PADDLE_HEIGHT, PADDLE_DEPTH }, COLOR_SKYBLUE);
+        DrawCubeWiresV(arena.paddleDrawPos, { PADDLE_WIDTH, PADDLE_HEIGHT, PADDLE_DEPTH }, COLOR_DARKBLUE);
+        entityCosts.AddDraw((int)EntityType::Paddle, 2, CUBE_TRIANGLES);
+        entityCosts.AddTime((int)EntityType::Paddle, CostPhase::Render, costTimer.Lap());
 
         // Draw ball
-        RVec3 bPos = bodyInterface.GetPosition(gBallId);
-        Vector3 ballDrawPos = JoltToRaylib(bPos);
-        DrawSphere(ballDrawPos, BALL_RADIUS, COLOR_YELLOW);
-        DrawSphereWires(ballDrawPos, BALL_RADIUS, 8, 8, COLOR_ORANGE);
+        DrawSphere(arena.ballDrawPos, BALL_RADIUS, COLOR_YELLOW);
+        DrawSphereWires(arena.ballDrawPos, BALL_RADIUS, 8, 8, COLOR_ORANGE);
+        entityCosts.AddDraw((int)EntityType::Ball, 2, SPHERE_TRIANGLES);
+        entityCosts.AddTime((int)EntityType::Ball, CostPhase::Render, costTimer.Lap());
 
         // Draw targets
+        int activeTargets = 0;
         for (const auto& target : gameState.targets) {
             if (target.active) {
                 DrawCubeV(target.position, { TARGET_SIZE, TARGET_SIZE, TARGET_SIZE }, target.color);
                 DrawCubeWiresV(target.position, { TARGET_SIZE, TARGET_SIZE, TARGET_SIZE }, COLOR_BLACK);
+                activeTargets++;
+            }
+        }
+        entityCosts.AddDraw((int)EntityType::Target, 2 * activeTargets, activeTargets * CUBE_TRIANGLES);
+        entityCosts.AddTime((int)EntityType::Target, CostPhase::Render, costTimer.Lap());
+
+        // Draw chain
+        const vector<Vector3>& chainPos = arena.chainDrawPos;
+        for (size_t i = 0; i < chainPos.size(); i++) {
+            DrawSphereEx(chainPos[i], CHAIN_LINK_RADIUS, 6, 6, COLOR_GRAY);
+            if (i > 0) DrawLine3D(chainPos[i - 1], chainPos[i], COLOR_WHITE);
+        }
+        entityCosts.AddDraw((int)EntityType::ChainLink, 2 * (int)chainPos.size(), (int)chainPos.size() * LINK_TRIANGLES);
+        entityCosts.AddTime((int)EntityType::ChainLink, CostPhase::Render, costTimer.Lap());
+
+        // Draw soft bodies; cloth is visible from both sides
+        int softBodyTriangles = 0;
+        for (size_t i = 0; i < softBodyMeshes.size(); i++) {
+            const SoftBodyEntity& entity = arena.softBodies.entities[i];
+            if (softBodyMeshes[i].vertexCount == 0) continue; // Rejected by CreateSoftBodyMesh
+            UpdateSoftBodyMesh(softBodyMeshes[i], entity);
+            if (entity.twoSided) rlDisableBackfaceCulling();
+            DrawMesh(softBodyMeshes[i], softBodyMaterial, MatrixIdentity());
+            if (entity.twoSided) rlEnableBackfaceCulling();
+            softBodyTriangles += softBodyMeshes[i].triangleCount;
+        }
+        entityCosts.AddDraw((int)EntityType::SoftBody, (int)softBodyMeshes.size(), softBodyTriangles);
+        entityCosts.AddTime((int)EntityType::SoftBody, CostPhase::Render, costTimer.Lap());
+
+        // Draw force fields last, water is translucent
+        int fieldTriangles = 0;
+        for (const ForceFieldDef& field : arena.forceFields.fields) {
+            Vector3 center = { field.center[0], field.center[1], field.center[2] };
+            Vector3 size = { 2 * field.halfExtent[0], 2 * field.halfExtent[1], 2 * field.halfExtent[2] };
+            switch (field.type) {
+            case ForceFieldType::Wind:
+                DrawCubeWiresV(center, size, COLOR_SKYBLUE);
+                break;
+            case ForceFieldType::GravityWell:
+                DrawSphereWires(center, field.radius, 8, 8, COLOR_GOLD);
+                break;
+            case ForceFieldType::Buoyancy:
+                DrawCubeV(center, size, COLOR_WATER);
+                fieldTriangles += CUBE_TRIANGLES;
+                break;
             }
         }
+        entityCosts.AddDraw((int)EntityType::ForceField, (int)arena.forceFields.fields.size(), fieldTriangles);
+        entityCosts.AddTime((int)EntityType::ForceField, CostPhase::Render, costTimer.Lap());
 
         EndMode3D();
 
@@ -540,13 +2918,19 @@ int main(void) {
         }
 
         // Controls help
-        DrawRectangle(SCREEN_WIDTH - 220, 10, 210, 100, COLOR_UI_BG);
-        DrawRectangleLines(SCREEN_WIDTH - 220, 10, 210, 100, COLOR_WHITE);
+        DrawRectangle(SCREEN_WIDTH - 220, 10, 210, 136, COLOR_UI_BG);
+        DrawRectangleLines(SCREEN_WIDTH - 220, 10, 210, 136, COLOR_WHITE);
         DrawText("Controls:", SCREEN_WIDTH - 210, 20, 16, COLOR_WHITE);
         DrawText("WASD/Arrows - Move paddle", SCREEN_WIDTH - 210, 40, 14, COLOR_GRAY);
         DrawText("SPACE - Launch ball", SCREEN_WIDTH - 210, 58, 14, COLOR_GRAY);
-        DrawText("R - Reset game", SCREEN_WIDTH - 210, 76, 14, COLOR_GRAY);
-        DrawText("ESC - Quit", SCREEN_WIDTH - 210, 94, 14, COLOR_GRAY);
+        DrawText("E - Explode", SCREEN_WIDTH - 210, 76, 14, COLOR_GRAY);
+        DrawText("R - Reset game", SCREEN_WIDTH - 210, 94, 14, COLOR_GRAY);
+        DrawText("F2 - Entity costs", SCREEN_WIDTH - 210, 112, 14, COLOR_GRAY);
+        DrawText("ESC - Quit", SCREEN_WIDTH - 210, 130, 14, COLOR_GRAY);
+
+        if (showEntityCosts) {
+            DrawEntityCostOverlay(entityCosts, 286, 16, 8);
+        }
 
         // Target legend
         DrawRectangle(10, SCREEN_HEIGHT - 90, 180, 80, COLOR_UI_BG);
@@ -560,7 +2944,7 @@ int main(void) {
         DrawText("Low (10 pts)", 40, SCREEN_HEIGHT - 24, 14, COLOR_GREEN);
 
         // Game over screen
-        if (gameOver) {
+        if (arena.gameOver) {
             DrawRectangle(SCREEN_WIDTH/2 - 150, SCREEN_HEIGHT/2 - 60, 300, 120, COLOR_UI_BG_DARK);
             DrawRectangleLines(SCREEN_WIDTH/2 - 150, SCREEN_HEIGHT/2 - 60, 300, 120, COLOR_RED);
             DrawText("GAME OVER", SCREEN_WIDTH/2 - 80, SCREEN_HEIGHT/2 - 40, 30, COLOR_RED);
@@ -568,34 +2952,66 @@ int main(void) {
             DrawText("Press R to restart", SCREEN_WIDTH/2 - 70, SCREEN_HEIGHT/2 + 30, 16, COLOR_YELLOW);
         }
 
+        if (cutscene.IsPlaying()) {
+            cutscene.DrawCaptions(30, COLOR_WHITE);
+            DrawText("SPACE - Skip", SCREEN_WIDTH / 2 - 50, SCREEN_HEIGHT - 30, 16, COLOR_GRAY);
+        }
+
+        if (capture.IsRunning()) {
+            profiler.BeginZone("Capture");
+            capture.Capture();
+            profiler.EndZone();
+        }
         EndDrawing();
+        profiler.EndZone();
+
+        // Populations are cheap to take from game state, so refresh them every frame
+        entityCosts.SetPopulation((int)EntityType::Floor, 1, 0);
+        entityCosts.SetPopulation((int)EntityType::Wall, 3, 0);
+        entityCosts.SetPopulation((int)EntityType::StaticRegion, (int)arena.staticWorld.regions.size(), (int)arena.staticWorld.regions.size());
+        entityCosts.SetPopulation((int)EntityType::Paddle, 1, 1);
+        entityCosts.SetPopulation((int)EntityType::Ball, 1, 1);
+        entityCosts.SetPopulation((int)EntityType::Target, activeTargets, (int)gameState.targets.size());
+        entityCosts.SetPopulation((int)EntityType::ChainLink, (int)arena.chainDrawPos.size(), (int)arena.chainDrawPos.size());
+        entityCosts.SetPopulation((int)EntityType::SoftBody, (int)arena.softBodies.entities.size(), (int)arena.softBodies.entities.size());
+        entityCosts.SetPopulation((int)EntityType::ForceField, (int)arena.forceFields.fields.size(), 0);
+        entityCosts.EndFrame();
+
+        RecordFrameMetrics(GetFrameTime());
+        profiler.EndFrame();
+    }
+
+    // Report which entity types cost the most over the session
+    cout << entityCosts.FormatReport();
+    if (const char* reportPath = GetEntityReportPath()) {
+        if (entityCosts.WriteReport(reportPath)) cout << "Entity cost report written to " << reportPath << endl;
+    }
+
+    if (recordPath != nullptr) {
+        if (SaveSession(session, recordPath)) cout << "Session recorded to " << recordPath << endl;
     }
+    capture.Stop();
+    cutscene.Skip();
+
+    for (const Mesh& mesh : softBodyMeshes) {
+        if (mesh.vertexCount > 0) UnloadMesh(mesh);
+    }
+    UnloadMaterial(softBodyMaterial);
 
     // Cleanup physics
-    bodyInterface.RemoveBody(gBallId);
-    bodyInterface.DestroyBody(gBallId);
-    bodyInterface.RemoveBody(paddleId);
-    bodyInterface.DestroyBody(paddleId);
-    bodyInterface.RemoveBody(floor->GetID());
-    bodyInterface.DestroyBody(floor->GetID());
-    bodyInterface.RemoveBody(backWall->GetID());
-    bodyInterface.DestroyBody(backWall->GetID());
-    bodyInterface.RemoveBody(leftWall->GetID());
-    bodyInterface.DestroyBody(leftWall->GetID());
-    bodyInterface.RemoveBody(rightWall->GetID());
-    bodyInterface.DestroyBody(rightWall->GetID());
-
-    for (auto& target : gameState.targets) {
-        if (bodyInterface.IsAdded(target.bodyId)) {
-            bodyInterface.RemoveBody(target.bodyId);
-            bodyInterface.DestroyBody(target.bodyId);
-        }
+    ShutdownArena(arena);
+
+#ifdef LEVELFORGE_ALLOC_TRACKING
+    if (WriteAllocReport("alloc_report.json")) {
+        cout << "Allocation report written to alloc_report.json" << endl;
     }
+#endif
 
     UnregisterTypes();
     delete Factory::sInstance;
     Factory::sInstance = nullptr;
 
+    if (IsAudioDeviceReady()) CloseAudioDevice();
     CloseWindow();
     return 0;
 }
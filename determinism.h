@@ -0,0 +1,320 @@
+// Determinism verification
+// Replays a recorded input session headlessly and hashes the world every tick,
+// so runs under different configurations (physics thread counts, -O2 vs PGO
+// builds) can be compared tick by tick. The first divergent tick is reported
+// along with the first body whose state differs.
+//
+// A session is the seed for the game's random generator plus one button mask
+// and timestep per tick. The game decides what the bits mean. Traces can be
+// saved and compared later, which is how separate builds are checked against
+// each other.
+//
+// Sessions can also carry keyframes: game-defined world snapshots taken every
+// so often while recording. Seeking restores the latest keyframe at or before
+// the wanted tick and simulates only the ticks after it.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Seeded generator for anything that feeds the simulation. Unlike rand() or
+// std::uniform_int_distribution, it gives the same sequence on every platform.
+class DeterministicRandom {
+public:
+    explicit DeterministicRandom(uint64_t seed = 1) { Seed(seed); }
+
+    void Seed(uint64_t seed) { mState = seed != 0 ? seed : 0x9e3779b97f4a7c15ull; }
+
+    uint32_t Next() {
+        // xorshift64*
+        mState ^= mState >> 12;
+        mState ^= mState << 25;
+        mState ^= mState >> 27;
+        return (uint32_t)((mState * 0x2545f4914f6cdd1dull) >> 32);
+    }
+
+    // For snapshots: the generator continues exactly where it left off
+    uint64_t GetState() const { return mState; }
+    void SetState(uint64_t state) { mState = state; }
+
+    // Uniform integer in [min, max]
+    int Range(int min, int max) {
+        if (max <= min) return min;
+        return min + (int)(Next() % (uint32_t)(max - min + 1));
+    }
+
+private:
+    uint64_t mState;
+};
+
+struct SessionTick {
+    uint32_t buttons;
+    float dt;
+};
+
+struct SessionKeyframe {
+    uint32_t tick;                   // World state before this tick runs
+    std::vector<unsigned char> data; // Snapshot, in the game's own format
+};
+
+struct Session {
+    uint64_t seed = 1;
+    std::vector<SessionTick> ticks;
+    std::vector<SessionKeyframe> keyframes; // In tick order
+
+    // Latest keyframe at or before the tick, or nullptr to start from the beginning
+    const SessionKeyframe* FindKeyframe(uint32_t tick) const {
+        const SessionKeyframe* found = nullptr;
+        for (const SessionKeyframe& keyframe : keyframes) {
+            if (keyframe.tick > tick) break;
+            found = &keyframe;
+        }
+        return found;
+    }
+};
+
+// Session files are text: "seed <n>" followed by "<buttons> <dt bits>" per
+// tick. dt is stored as raw bits so replays see exactly the recorded value.
+// Keyframes follow the ticks as "keyframe <tick> <bytes>" and a line of hex.
+inline bool SaveSession(const Session& session, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) return false;
+
+    fprintf(file, "seed %llu\n", (unsigned long long)session.seed);
+    for (const SessionTick& tick : session.ticks) {
+        uint32_t dtBits;
+        memcpy(&dtBits, &tick.dt, sizeof(dtBits));
+        fprintf(file, "%u %08x\n", tick.buttons, dtBits);
+    }
+    for (const SessionKeyframe& keyframe : session.keyframes) {
+        fprintf(file, "keyframe %u %zu\n", keyframe.tick, keyframe.data.size());
+        for (unsigned char byte : keyframe.data) fprintf(file, "%02x", byte);
+        fputc('\n', file);
+    }
+    fclose(file);
+    return true;
+}
+
+inline bool LoadSession(const char* path, Session& session) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) return false;
+
+    unsigned long long seed = 0;
+    if (fscanf(file, "seed %llu", &seed) != 1) {
+        fclose(file);
+        return false;
+    }
+    session.seed = seed;
+    session.ticks.clear();
+
+    unsigned buttons, dtBits;
+    while (fscanf(file, "%u %x", &buttons, &dtBits) == 2) {
+        SessionTick tick;
+        tick.buttons = buttons;
+        memcpy(&tick.dt, &dtBits, sizeof(dtBits));
+        session.ticks.push_back(tick);
+    }
+
+    session.keyframes.clear();
+    unsigned keyframeTick;
+    size_t size;
+    while (fscanf(file, " keyframe %u %zu ", &keyframeTick, &size) == 2) {
+        SessionKeyframe keyframe;
+        keyframe.tick = keyframeTick;
+        keyframe.data.resize(size);
+        for (size_t i = 0; i < size; i++) {
+            unsigned byte;
+            if (fscanf(file, "%2x", &byte) != 1) {
+                fclose(file);
+                return false;
+            }
+            keyframe.data[i] = (unsigned char)byte;
+        }
+        session.keyframes.push_back(std::move(keyframe));
+    }
+    fclose(file);
+    return true;
+}
+
+// Generate a session that holds random combinations of the given buttons for
+// random stretches. pulseButtons are only ever pressed for a single tick.
+inline Session MakeScriptedSession(uint64_t seed, int tickCount, float dt, uint32_t holdButtons, uint32_t pulseButtons) {
+    Session session;
+    session.seed = seed;
+    DeterministicRandom random(seed ^ 0x5e55105ull);
+
+    uint32_t held = 0;
+    int holdTicks = 0;
+    for (int i = 0; i < tickCount; i++) {
+        if (holdTicks-- <= 0) {
+            held = random.Next() & holdButtons;
+            holdTicks = random.Range(5, 60);
+        }
+        uint32_t pulse = random.Range(0, 90) == 0 ? (random.Next() & pulseButtons) : 0;
+        session.ticks.push_back({ held | pulse, dt });
+    }
+    return session;
+}
+
+// FNV-1a over raw bytes. Floats are hashed by bit pattern, so any difference
+// at all, even in the last bit, shows up.
+class StateHasher {
+public:
+    void Add(const void* data, size_t size) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++) {
+            mHash = (mHash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+
+    template <typename T>
+    void Add(const T& value) { Add(&value, sizeof(T)); }
+
+    uint64_t Get() const { return mHash; }
+
+private:
+    uint64_t mHash = 1469598103934665603ull;
+};
+
+struct BodyHash {
+    uint64_t id;
+    uint64_t hash;
+};
+
+struct TickHash {
+    uint64_t world;
+    std::vector<BodyHash> bodies;
+};
+
+struct DeterminismTrace {
+    std::string label;
+    std::vector<TickHash> ticks;
+
+    // Bodies must be recorded in a stable order. gameHash covers non-physics
+    // state such as score.
+    void RecordTick(std::vector<BodyHash> bodies, uint64_t gameHash) {
+        StateHasher hasher;
+        hasher.Add(gameHash);
+        for (const BodyHash& body : bodies) {
+            hasher.Add(body.id);
+            hasher.Add(body.hash);
+        }
+        ticks.push_back({ hasher.Get(), std::move(bodies) });
+    }
+};
+
+// Trace files are text: "<world hash> <body count>" per tick, then one
+// "<id> <hash>" line per body
+inline bool SaveTrace(const DeterminismTrace& trace, const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) return false;
+
+    for (const TickHash& tick : trace.ticks) {
+        fprintf(file, "%016llx %zu\n", (unsigned long long)tick.world, tick.bodies.size());
+        for (const BodyHash& body : tick.bodies) {
+            fprintf(file, "%016llx %016llx\n", (unsigned long long)body.id, (unsigned long long)body.hash);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+inline bool LoadTrace(const char* path, DeterminismTrace& trace) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) return false;
+
+    trace.label = path;
+    trace.ticks.clear();
+    unsigned long long world, id, hash;
+    size_t bodyCount;
+    while (fscanf(file, "%llx %zu", &world, &bodyCount) == 2) {
+        TickHash tick;
+        tick.world = world;
+        for (size_t i = 0; i < bodyCount && fscanf(file, "%llx %llx", &id, &hash) == 2; i++) {
+            tick.bodies.push_back({ id, hash });
+        }
+        trace.ticks.push_back(std::move(tick));
+    }
+    fclose(file);
+    return true;
+}
+
+struct Divergence {
+    int tick = -1;       // -1 when the traces match
+    uint64_t body = 0;   // First body whose hash differs
+    bool bodyFound = false;
+};
+
+inline Divergence FindDivergence(const DeterminismTrace& reference, const DeterminismTrace& candidate) {
+    Divergence divergence;
+    size_t tickCount = std::min(reference.ticks.size(), candidate.ticks.size());
+    for (size_t t = 0; t < tickCount; t++) {
+        const TickHash& a = reference.ticks[t];
+        const TickHash& b = candidate.ticks[t];
+        if (a.world == b.world) continue;
+
+        divergence.tick = (int)t;
+        size_t bodyCount = std::min(a.bodies.size(), b.bodies.size());
+        for (size_t i = 0; i < bodyCount; i++) {
+            if (a.bodies[i].id != b.bodies[i].id || a.bodies[i].hash != b.bodies[i].hash) {
+                divergence.body = a.bodies[i].id;
+                divergence.bodyFound = true;
+                break;
+            }
+        }
+        if (!divergence.bodyFound && a.bodies.size() != b.bodies.size()) {
+            const BodyHash& extra = a.bodies.size() > b.bodies.size() ? a.bodies[bodyCount] : b.bodies[bodyCount];
+            divergence.body = extra.id;
+            divergence.bodyFound = true;
+        }
+        return divergence;
+    }
+
+    // A shorter trace that matches so far still counts as diverged
+    if (reference.ticks.size() != candidate.ticks.size()) divergence.tick = (int)tickCount;
+    return divergence;
+}
+
+// Print the comparison and return true when the traces match.
+// describeBody turns a body id into something readable.
+inline bool ReportDeterminism(const DeterminismTrace& reference, const DeterminismTrace& candidate,
+                              const std::function<std::string(uint64_t)>& describeBody) {
+    Divergence divergence = FindDivergence(reference, candidate);
+    if (divergence.tick < 0) {
+        printf("MATCH    %-24s %zu ticks\n", candidate.label.c_str(), candidate.ticks.size());
+        return true;
+    }
+
+    if (divergence.bodyFound) {
+        printf("DIVERGED %-24s at tick %d, body %s (reference: %s)\n", candidate.label.c_str(), divergence.tick,
+            describeBody(divergence.body).c_str(), reference.label.c_str());
+    } else if (divergence.tick >= (int)std::min(reference.ticks.size(), candidate.ticks.size())) {
+        printf("DIVERGED %-24s length %zu vs %zu ticks (reference: %s)\n", candidate.label.c_str(),
+            candidate.ticks.size(), reference.ticks.size(), reference.label.c_str());
+    } else {
+        printf("DIVERGED %-24s at tick %d, game state only (reference: %s)\n", candidate.label.c_str(),
+            divergence.tick, reference.label.c_str());
+    }
+    return false;
+}
+
+// Parse a comma separated list of thread counts, e.g. "1,2,4,32"
+inline std::vector<int> ParseThreadCounts(const char* list) {
+    std::vector<int> counts;
+    const char* cursor = list;
+    while (*cursor != '\0') {
+        char* end;
+        long value = strtol(cursor, &end, 10);
+        if (end == cursor) break;
+        if (value > 0) counts.push_back((int)value);
+        cursor = *end == ',' ? end + 1 : end;
+    }
+    return counts;
+}
@@ -0,0 +1,248 @@
+// Per-entity-type cost attribution
+// Splits each frame's update, physics and render cost between entity types so
+// a slow level can be traced back to the kind of entity responsible. The game
+// registers its types once, then each frame records per type: entity and body
+// counts, awake bodies, contacts touching the type, draw items and triangles
+// submitted, and the time spent in that type's update and render code.
+//
+// The physics step can't be timed per body, so its time is shared between
+// types in proportion to awake bodies plus contacts. Rows are kept both as a
+// smoothed recent view (for the overlay) and as a whole-run average (for the
+// report printed at exit, and written to LEVELFORGE_ENTITY_REPORT if set).
+//
+// Everything except AddContact is main-thread only. AddContact may be called
+// from physics callbacks.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+constexpr int kMaxEntityTypes = 16;
+
+enum class CostPhase { Update, Render };
+
+struct EntityCostRow {
+    const char* name;
+    double entities;
+    double bodies;
+    double activeBodies;
+    double contacts;
+    double drawItems;
+    double triangles;
+    double updateMs;
+    double physicsMs;
+    double renderMs;
+
+    double TotalMs() const { return updateMs + physicsMs + renderMs; }
+};
+
+class EntityCostTable {
+public:
+    // Types are indexed in registration order
+    int AddType(const char* name) {
+        if (mTypeCount >= kMaxEntityTypes) return -1;
+        int type = mTypeCount++;
+        mFrame[type] = { name };
+        mSmoothed[type] = { name };
+        mTotals[type] = { name };
+        return type;
+    }
+
+    void BeginFrame() {
+        for (int i = 0; i < mTypeCount; i++) {
+            mFrame[i] = { mFrame[i].name };
+            mContacts[i].store(0, std::memory_order_relaxed);
+        }
+        mPhysicsMs = 0.0;
+    }
+
+    void SetPopulation(int type, int entities, int bodies) {
+        if (!IsValid(type)) return;
+        mFrame[type].entities = entities;
+        mFrame[type].bodies = bodies;
+    }
+
+    void AddActiveBodies(int type, int count = 1) {
+        if (IsValid(type)) mFrame[type].activeBodies += count;
+    }
+
+    void AddContact(int type) {
+        if (IsValid(type)) mContacts[type].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void AddDraw(int type, int drawItems, int triangles) {
+        if (!IsValid(type)) return;
+        mFrame[type].drawItems += drawItems;
+        mFrame[type].triangles += triangles;
+    }
+
+    void AddTime(int type, CostPhase phase, double milliseconds) {
+        if (!IsValid(type)) return;
+        double& slot = phase == CostPhase::Update ? mFrame[type].updateMs : mFrame[type].renderMs;
+        slot += milliseconds;
+    }
+
+    // Time spent stepping the physics world this frame, shared out in EndFrame
+    void AddPhysicsTime(double milliseconds) {
+        mPhysicsMs += milliseconds;
+    }
+
+    // Share out the physics step and fold this frame into the averages
+    void EndFrame() {
+        double totalWeight = 0.0;
+        for (int i = 0; i < mTypeCount; i++) {
+            mFrame[i].contacts = mContacts[i].load(std::memory_order_relaxed);
+            totalWeight += mFrame[i].activeBodies + mFrame[i].contacts;
+        }
+
+        const double alpha = mFrameCount == 0 ? 1.0 : kSmoothing;
+        for (int i = 0; i < mTypeCount; i++) {
+            EntityCostRow& frame = mFrame[i];
+            if (totalWeight > 0.0) {
+                frame.physicsMs = mPhysicsMs * (frame.activeBodies + frame.contacts) / totalWeight;
+            }
+            Blend(mSmoothed[i], frame, alpha);
+            Accumulate(mTotals[i], frame);
+        }
+        mFrameCount++;
+    }
+
+    // Rows sorted by total cost, most expensive first. wholeRun averages over
+    // every frame since startup instead of the recent smoothed view.
+    std::vector<EntityCostRow> Sorted(bool wholeRun) const {
+        std::vector<EntityCostRow> rows;
+        for (int i = 0; i < mTypeCount; i++) {
+            if (!wholeRun) {
+                rows.push_back(mSmoothed[i]);
+                continue;
+            }
+            EntityCostRow row = mTotals[i];
+            Scale(row, mFrameCount > 0 ? 1.0 / mFrameCount : 0.0);
+            rows.push_back(row);
+        }
+        std::stable_sort(rows.begin(), rows.end(), [](const EntityCostRow& a, const EntityCostRow& b) {
+            return a.TotalMs() > b.TotalMs();
+        });
+        return rows;
+    }
+
+    uint64_t GetFrameCount() const { return mFrameCount; }
+
+    // Fixed-width text table of per-frame averages over the whole run
+    std::string FormatReport() const {
+        std::string report;
+        char line[256];
+        snprintf(line, sizeof(line), "Entity cost per frame, averaged over %llu frames\n", (unsigned long long)mFrameCount);
+        report += line;
+        snprintf(line, sizeof(line), "%-16s %8s %8s %8s %8s %8s %10s %9s %9s %9s %9s\n",
+            "type", "entities", "bodies", "awake", "contacts", "draws", "triangles",
+            "update_ms", "physics_ms", "render_ms", "total_ms");
+        report += line;
+        for (const EntityCostRow& row : Sorted(true)) {
+            snprintf(line, sizeof(line), "%-16s %8.1f %8.1f %8.1f %8.1f %8.1f %10.0f %9.3f %9.3f %9.3f %9.3f\n",
+                row.name, row.entities, row.bodies, row.activeBodies, row.contacts, row.drawItems, row.triangles,
+                row.updateMs, row.physicsMs, row.renderMs, row.TotalMs());
+            report += line;
+        }
+        return report;
+    }
+
+    bool WriteReport(const char* path) const {
+        FILE* file = fopen(path, "w");
+        if (file == nullptr) return false;
+        fputs(FormatReport().c_str(), file);
+        fclose(file);
+        return true;
+    }
+
+private:
+    static constexpr double kSmoothing = 0.05;
+
+    bool IsValid(int type) const { return type >= 0 && type < mTypeCount; }
+
+    static void Blend(EntityCostRow& into, const EntityCostRow& from, double alpha) {
+        into.entities += (from.entities - into.entities) * alpha;
+        into.bodies += (from.bodies - into.bodies) * alpha;
+        into.activeBodies += (from.activeBodies - into.activeBodies) * alpha;
+        into.contacts += (from.contacts - into.contacts) * alpha;
+        into.drawItems += (from.drawItems - into.drawItems) * alpha;
+        into.triangles += (from.triangles - into.triangles) * alpha;
+        into.updateMs += (from.updateMs - into.updateMs) * alpha;
+        into.physicsMs += (from.physicsMs - into.physicsMs) * alpha;
+        into.renderMs += (from.renderMs - into.renderMs) * alpha;
+    }
+
+    static void Accumulate(EntityCostRow& into, const EntityCostRow& from) {
+        into.entities += from.entities;
+        into.bodies += from.bodies;
+        into.activeBodies += from.activeBodies;
+        into.contacts += from.contacts;
+        into.drawItems += from.drawItems;
+        into.triangles += from.triangles;
+        into.updateMs += from.updateMs;
+        into.physicsMs += from.physicsMs;
+        into.renderMs += from.renderMs;
+    }
+
+    static void Scale(EntityCostRow& row, double factor) {
+        row.entities *= factor;
+        row.bodies *= factor;
+        row.activeBodies *= factor;
+        row.contacts *= factor;
+        row.drawItems *= factor;
+        row.triangles *= factor;
+        row.updateMs *= factor;
+        row.physicsMs *= factor;
+        row.renderMs *= factor;
+    }
+
+    int mTypeCount = 0;
+    uint64_t mFrameCount = 0;
+    double mPhysicsMs = 0.0;
+    EntityCostRow mFrame[kMaxEntityTypes] = {};
+    EntityCostRow mSmoothed[kMaxEntityTypes] = {};
+    EntityCostRow mTotals[kMaxEntityTypes] = {};
+    std::atomic<int> mContacts[kMaxEntityTypes] = {};
+};
+
+// Report path from LEVELFORGE_ENTITY_REPORT, or nullptr when unset
+inline const char* GetEntityReportPath() {
+    return getenv("LEVELFORGE_ENTITY_REPORT");
+}
+
+#ifdef RAYLIB_H
+// Draw the smoothed table, most expensive type first
+inline void DrawEntityCostOverlay(const EntityCostTable& table, int x, int y, int maxRows) {
+    static const char* const kHeaders[] = { "type", "ents", "awake", "cont", "draws", "tris", "upd", "phys", "rend", "total" };
+    static const int kColumnX[] = { 0, 110, 155, 205, 250, 300, 360, 410, 460, 510 };
+    const int columnCount = 10;
+    const int rowHeight = 14;
+
+    std::vector<EntityCostRow> rows = table.Sorted(false);
+    int shownRows = std::min((int)rows.size(), maxRows);
+    DrawRectangle(x - 6, y - 6, 580, (shownRows + 1) * rowHeight + 12, Color{ 0, 0, 0, 180 });
+
+    for (int column = 0; column < columnCount; column++) {
+        DrawText(kHeaders[column], x + kColumnX[column], y, 10, GRAY);
+    }
+    for (int i = 0; i < shownRows; i++) {
+        const EntityCostRow& row = rows[i];
+        int rowY = y + (i + 1) * rowHeight;
+        DrawText(row.name, x + kColumnX[0], rowY, 10, WHITE);
+        DrawText(TextFormat("%.0f", row.entities), x + kColumnX[1], rowY, 10, WHITE);
+        DrawText(TextFormat("%.0f", row.activeBodies), x + kColumnX[2], rowY, 10, WHITE);
+        DrawText(TextFormat("%.0f", row.contacts), x + kColumnX[3], rowY, 10, WHITE);
+        DrawText(TextFormat("%.0f", row.drawItems), x + kColumnX[4], rowY, 10, WHITE);
+        DrawText(TextFormat("%.0f", row.triangles), x + kColumnX[5], rowY, 10, WHITE);
+        DrawText(TextFormat("%.2f", row.updateMs), x + kColumnX[6], rowY, 10, WHITE);
+        DrawText(TextFormat("%.2f", row.physicsMs), x + kColumnX[7], rowY, 10, WHITE);
+        DrawText(TextFormat("%.2f", row.renderMs), x + kColumnX[8], rowY, 10, WHITE);
+        DrawText(TextFormat("%.2f", row.TotalMs()), x + kColumnX[9], rowY, 10, YELLOW);
+    }
+}
+#endif
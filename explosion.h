@@ -0,0 +1,108 @@
+// Explosions
+// Engine-neutral description of the `explode` action: a radial impulse around
+// a point that falls off with distance. Gameplay queues explosions and the
+// physics side applies every explosion queued for the step together. 3D does
+// one broadphase query per explosion and one impulse per body, however many
+// explosions overlap it. 2D hands each explosion to b2World_Explode.
+//
+// Box2D only falls off linearly, so other curves are split into a few linear
+// ramps whose sum follows the curve (see ExplosionRamps). Box2D's impulse is
+// per unit of exposed shape perimeter; Jolt's is per body.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+enum class ExplosionFalloff {
+    Constant,  // Full impulse out to the radius
+    Linear,    // 1 - d/r
+    Quadratic, // (1 - d/r)^2, most of the push close to the center
+};
+
+struct ExplosionDef {
+    float x, y, z;    // Center; z is ignored in 2D
+    float radius;     // Nothing beyond this is pushed
+    float impulse;    // At the center
+    ExplosionFalloff falloff;
+};
+
+// Impulse scale at distance from the center, 0 at or past the radius
+inline float ExplosionScale(ExplosionFalloff falloff, float distance, float radius) {
+    if (radius <= 0.0f || distance >= radius) return 0.0f;
+    float t = 1.0f - distance / radius;
+    switch (falloff) {
+    case ExplosionFalloff::Constant:  return 1.0f;
+    case ExplosionFalloff::Linear:    return t;
+    case ExplosionFalloff::Quadratic: return t * t;
+    }
+    return 0.0f;
+}
+
+// A linear ramp pushes with weight * (1 - d/radius) inside radius
+struct ExplosionRamp {
+    float radius;
+    float weight;
+};
+
+// Split a falloff curve into linear ramps for engines that only fall off
+// linearly. The ramps end at evenly spaced radii and their sum matches the
+// curve exactly at each of those radii. Constant is not a ramp and yields none.
+inline std::vector<ExplosionRamp> ExplosionRamps(ExplosionFalloff falloff, float radius, int segments = 3) {
+    std::vector<ExplosionRamp> ramps;
+    if (falloff == ExplosionFalloff::Constant || radius <= 0.0f) return ramps;
+    if (falloff == ExplosionFalloff::Linear) segments = 1;
+
+    // The sum's slope on segment k is minus the weight/radius of every ramp
+    // still reaching it, so walk in from the outside peeling off one ramp per
+    // segment
+    float step = radius / segments;
+    float slopeSoFar = 0.0f;
+    ramps.resize(segments);
+    for (int k = segments - 1; k >= 0; k--) {
+        float inner = k * step;
+        float outer = inner + step;
+        float slope = (ExplosionScale(falloff, outer, radius) - ExplosionScale(falloff, inner, radius)) / step;
+        float rampRadius = outer;
+        float weight = -(slope - slopeSoFar) * rampRadius;
+        ramps[k] = { rampRadius, std::max(0.0f, weight) };
+        slopeSoFar -= ramps[k].weight / rampRadius;
+    }
+    return ramps;
+}
+
+// Parse the arguments of "explode:<x>,<y>[,<z>],<radius>,<impulse>[,<falloff>]"
+// where falloff is constant, linear (default) or quadratic. is3D picks whether
+// three or two coordinates come first.
+inline bool ParseExplodeAction(const char* args, bool is3D, ExplosionDef& def) {
+    float values[5] = {};
+    int wanted = is3D ? 5 : 4;
+    const char* cursor = args;
+    for (int i = 0; i < wanted; i++) {
+        int consumed = 0;
+        if (sscanf(cursor, " %f%n", &values[i], &consumed) != 1) return false;
+        cursor += consumed;
+        if (i + 1 < wanted && *cursor++ != ',') return false;
+    }
+
+    def.x = values[0];
+    def.y = values[1];
+    def.z = is3D ? values[2] : 0.0f;
+    def.radius = values[wanted - 2];
+    def.impulse = values[wanted - 1];
+    def.falloff = ExplosionFalloff::Linear;
+
+    if (*cursor == ',') {
+        cursor++;
+        while (*cursor == ' ') cursor++;
+        if (strcmp(cursor, "constant") == 0) def.falloff = ExplosionFalloff::Constant;
+        else if (strcmp(cursor, "quadratic") == 0) def.falloff = ExplosionFalloff::Quadratic;
+        else if (strcmp(cursor, "linear") != 0) return false;
+    } else if (*cursor != '\0') {
+        return false;
+    }
+    return def.radius > 0.0f;
+}
@@ -0,0 +1,129 @@
+// Force fields
+// Engine-neutral description of the `force_fields:` section of a screen:
+// volumes that push whatever is inside them every step. Wind drags bodies
+// toward the wind's velocity, gravity wells pull toward their center, and
+// buoyancy volumes are water that the physics engine floats bodies in.
+//
+// The engine gathers the bodies overlapping each field once per step into a
+// ForceFieldBatch (structure of arrays), then ApplyFieldAccelerations runs
+// each field over the whole batch in one branch-free loop the compiler can
+// vectorize. The result is an acceleration per body, which the engine turns
+// into one force per body. Buoyancy needs the body's shape, so the engine
+// handles it itself (Jolt's ApplyBuoyancyImpulse); it is skipped here.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+enum class ForceFieldType {
+    Wind,        // Box; drags velocity toward `velocity` at `strength` per second
+    GravityWell, // Sphere; pulls toward the center at `strength` m/s^2, fading to 0 at the radius
+    Buoyancy,    // Box of water whose surface is the top face
+};
+
+struct ForceFieldDef {
+    ForceFieldType type;
+    float center[3];
+    float halfExtent[3]; // Wind and buoyancy volumes
+    float radius;        // Gravity wells
+    float velocity[3];   // Wind velocity, or the water's current
+    float strength;      // Wind drag rate or well acceleration
+    float buoyancy;      // Water: 1 is neutral, higher floats
+    float linearDrag;    // Water
+    float angularDrag;   // Water
+};
+
+// Axis-aligned bounds of the field's volume
+inline void ForceFieldBounds(const ForceFieldDef& field, float outMin[3], float outMax[3]) {
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = field.type == ForceFieldType::GravityWell ? field.radius : field.halfExtent[axis];
+        outMin[axis] = field.center[axis] - extent;
+        outMax[axis] = field.center[axis] + extent;
+    }
+}
+
+// Whether a point is inside the field's volume
+inline bool ForceFieldContains(const ForceFieldDef& field, float x, float y, float z) {
+    float dx = x - field.center[0], dy = y - field.center[1], dz = z - field.center[2];
+    if (field.type == ForceFieldType::GravityWell) return dx * dx + dy * dy + dz * dz <= field.radius * field.radius;
+    return std::fabs(dx) <= field.halfExtent[0] && std::fabs(dy) <= field.halfExtent[1] && std::fabs(dz) <= field.halfExtent[2];
+}
+
+// Bodies overlapping any field this step. Positions are centers of mass.
+struct ForceFieldBatch {
+    std::vector<float> px, py, pz;
+    std::vector<float> vx, vy, vz;
+    std::vector<float> ax, ay, az; // Accumulated acceleration, output
+
+    void Clear() {
+        px.clear(); py.clear(); pz.clear();
+        vx.clear(); vy.clear(); vz.clear();
+        ax.clear(); ay.clear(); az.clear();
+    }
+
+    void Add(float x, float y, float z, float velX, float velY, float velZ) {
+        px.push_back(x); py.push_back(y); pz.push_back(z);
+        vx.push_back(velX); vy.push_back(velY); vz.push_back(velZ);
+        ax.push_back(0.0f); ay.push_back(0.0f); az.push_back(0.0f);
+    }
+
+    size_t Size() const { return px.size(); }
+};
+
+// Add one field's acceleration to every body in the batch it contains
+inline void ApplyFieldAcceleration(const ForceFieldDef& field, ForceFieldBatch& batch) {
+    const size_t count = batch.Size();
+    const float* px = batch.px.data();
+    const float* py = batch.py.data();
+    const float* pz = batch.pz.data();
+    float* ax = batch.ax.data();
+    float* ay = batch.ay.data();
+    float* az = batch.az.data();
+    const float cx = field.center[0], cy = field.center[1], cz = field.center[2];
+
+    switch (field.type) {
+    case ForceFieldType::Wind: {
+        const float* vx = batch.vx.data();
+        const float* vy = batch.vy.data();
+        const float* vz = batch.vz.data();
+        const float hx = field.halfExtent[0], hy = field.halfExtent[1], hz = field.halfExtent[2];
+        const float wx = field.velocity[0], wy = field.velocity[1], wz = field.velocity[2];
+        const float k = field.strength;
+        for (size_t i = 0; i < count; i++) {
+            float inside = (std::fabs(px[i] - cx) <= hx && std::fabs(py[i] - cy) <= hy && std::fabs(pz[i] - cz) <= hz) ? k : 0.0f;
+            ax[i] += (wx - vx[i]) * inside;
+            ay[i] += (wy - vy[i]) * inside;
+            az[i] += (wz - vz[i]) * inside;
+        }
+        break;
+    }
+    case ForceFieldType::GravityWell: {
+        const float radius = field.radius;
+        const float invRadius = radius > 0.0f ? 1.0f / radius : 0.0f;
+        const float g = field.strength;
+        for (size_t i = 0; i < count; i++) {
+            float dx = cx - px[i], dy = cy - py[i], dz = cz - pz[i];
+            float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+            // Fades in from the rim and out again near the center, so nothing
+            // sitting on the center is flung around
+            float pull = g * std::max(0.0f, 1.0f - distance * invRadius) * std::min(1.0f, distance);
+            float scale = pull / std::max(distance, 1.0e-4f);
+            ax[i] += dx * scale;
+            ay[i] += dy * scale;
+            az[i] += dz * scale;
+        }
+        break;
+    }
+    case ForceFieldType::Buoyancy:
+        break; // Needs the shape, left to the engine
+    }
+}
+
+// Run every field over the batch
+inline void ApplyFieldAccelerations(const std::vector<ForceFieldDef>& fields, ForceFieldBatch& batch) {
+    for (const ForceFieldDef& field : fields) {
+        ApplyFieldAcceleration(field, batch);
+    }
+}
@@ -0,0 +1,295 @@
+// Asynchronous frame capture
+// Records the window to numbered PNGs or a raw Y4M video without stalling the
+// GPU the way TakeScreenshot's glReadPixels does. Each frame's pixels are read
+// into one of a ring of pixel buffer objects. The copy runs on the GPU and the
+// buffer is only mapped a few frames later, once its fence has signalled. A
+// writer thread flips and encodes the mapped frames, so the main thread's cost
+// is one memcpy per frame.
+//
+// If the writer falls too far behind, frames are dropped rather than queued
+// without bound; the count is reported at shutdown. Y4M is the cheaper
+// format to keep up with (ffmpeg -i capture.y4m capture.mp4).
+//
+// Call Capture after the last draw of a frame and before EndDrawing. Capture
+// ends if the window is resized.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+constexpr int kCaptureRingSize = 3;      // Frames of readback latency
+constexpr size_t kCaptureMaxQueued = 8;  // Frames waiting for the writer before dropping
+
+enum class CaptureFormat { Png, Y4m };
+
+class FrameCapture {
+public:
+    ~FrameCapture() { Stop(); }
+
+    // Paths ending in .y4m record a video stream, anything else is a prefix
+    // for numbered PNGs (<path>_00000.png)
+    bool Start(const std::string& path, int fps) {
+        if (mRunning) return false;
+        mWidth = GetRenderWidth();
+        mHeight = GetRenderHeight();
+        mPath = path;
+        mFormat = path.size() > 4 && path.compare(path.size() - 4, 4, ".y4m") == 0 ? CaptureFormat::Y4m : CaptureFormat::Png;
+
+        if (mFormat == CaptureFormat::Y4m) {
+            mStream = fopen(path.c_str(), "wb");
+            if (mStream == nullptr) return false;
+            // Even dimensions for 4:2:0 chroma
+            mWidth &= ~1;
+            mHeight &= ~1;
+            fprintf(mStream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", mWidth, mHeight, fps);
+        }
+
+        size_t frameBytes = (size_t)mWidth * mHeight * 4;
+        glGenBuffers(kCaptureRingSize, mBuffers);
+        for (GLuint buffer : mBuffers) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+            glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        mHead = 0;
+        mInFlight = 0;
+        mFrameIndex = 0;
+        mFramesWritten = 0;
+        mFramesDropped = 0;
+        mCaptureMs = 0.0;
+        mWriterQuit = false;
+        mWriter = std::thread(&FrameCapture::WriterLoop, this);
+        mRunning = true;
+        return true;
+    }
+
+    void Capture() {
+        if (!mRunning) return;
+
+        // The buffers, and a Y4M stream's header, are sized at Start. After a
+        // resize glReadPixels would crop or overrun the framebuffer, so stop
+        // cleanly instead; Stop collects the frames still in flight first.
+        int width = GetRenderWidth();
+        int height = GetRenderHeight();
+        if (mFormat == CaptureFormat::Y4m) {
+            width &= ~1;
+            height &= ~1;
+        }
+        if (width != mWidth || height != mHeight) {
+            printf("Capture: window resized from %dx%d to %dx%d, stopping\n", mWidth, mHeight, width, height);
+            Stop();
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        // Everything queued in raylib's batch has to reach the framebuffer first
+        rlDrawRenderBatchActive();
+
+        // Reuse the oldest slot; its frame must be collected before being overwritten
+        if (mInFlight == kCaptureRingSize) Collect(true);
+
+        int slot = (mHead + mInFlight) % kCaptureRingSize;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, mBuffers[slot]);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        mFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        mSlotFrame[slot] = mFrameIndex++;
+        mInFlight++;
+
+        // Pick up whatever the GPU has already finished, without waiting
+        while (mInFlight > 0 && Collect(false)) {}
+
+        mCaptureMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Flush outstanding frames, finish writing and print a summary
+    void Stop() {
+        if (!mRunning) return;
+        while (mInFlight > 0) Collect(true);
+        glDeleteBuffers(kCaptureRingSize, mBuffers);
+
+        {
+            std::lock_guard<std::mutex> lock(mQueueMutex);
+            mWriterQuit = true;
+        }
+        mQueueWake.notify_one();
+        mWriter.join();
+        if (mStream != nullptr) fclose(mStream);
+        mStream = nullptr;
+        mRunning = false;
+
+        printf("Capture: %llu frames written to %s, %llu dropped, %.3f ms/frame on the main thread\n",
+            (unsigned long long)mFramesWritten, mPath.c_str(), (unsigned long long)mFramesDropped,
+            mFrameIndex > 0 ? mCaptureMs / mFrameIndex : 0.0);
+    }
+
+    bool IsRunning() const { return mRunning; }
+
+private:
+    struct CapturedFrame {
+        uint64_t index;
+        std::vector<unsigned char> rgba; // Bottom row first, as GL returns it
+    };
+
+    // Copy the oldest in-flight frame out of its buffer. Without wait, gives
+    // up (returning false) if the GPU hasn't finished with it yet.
+    bool Collect(bool wait) {
+        int slot = mHead;
+        GLenum status = glClientWaitSync(mFences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000ull : 0);
+        if (status == GL_TIMEOUT_EXPIRED && !wait) return false;
+        glDeleteSync(mFences[slot]);
+        mHead = (mHead + 1) % kCaptureRingSize;
+        mInFlight--;
+
+        CapturedFrame frame;
+        frame.index = mSlotFrame[slot];
+        {
+            std::lock_guard<std::mutex> lock(mQueueMutex);
+            if (mQueue.size() >= kCaptureMaxQueued) {
+                mFramesDropped++;
+                return true;
+            }
+            if (!mSpare.empty()) {
+                frame.rgba = std::move(mSpare.back());
+                mSpare.pop_back();
+            }
+        }
+
+        size_t frameBytes = (size_t)mWidth * mHeight * 4;
+        frame.rgba.resize(frameBytes);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, mBuffers[slot]);
+        const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes, GL_MAP_READ_BIT);
+        if (pixels != nullptr) {
+            memcpy(frame.rgba.data(), pixels, frameBytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (pixels == nullptr) return true;
+
+        {
+            std::lock_guard<std::mutex> lock(mQueueMutex);
+            mQueue.push_back(std::move(frame));
+        }
+        mQueueWake.notify_one();
+        return true;
+    }
+
+    void WriterLoop() {
+        std::unique_lock<std::mutex> lock(mQueueMutex);
+        while (true) {
+            mQueueWake.wait(lock, [this]() { return mWriterQuit || !mQueue.empty(); });
+            if (mQueue.empty()) return;
+
+            CapturedFrame frame = std::move(mQueue.front());
+            mQueue.pop_front();
+            lock.unlock();
+            if (mFormat == CaptureFormat::Y4m) WriteY4mFrame(frame);
+            else WritePngFrame(frame);
+            lock.lock();
+            mFramesWritten++;
+            mSpare.push_back(std::move(frame.rgba));
+        }
+    }
+
+    void WritePngFrame(CapturedFrame& frame) {
+        FlipRows(frame.rgba);
+        Image image = { frame.rgba.data(), mWidth, mHeight, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        char path[512];
+        snprintf(path, sizeof(path), "%s_%05llu.png", mPath.c_str(), (unsigned long long)frame.index);
+        ExportImage(image, path);
+    }
+
+    // Full range BT.601 with 2x2 averaged chroma, top row first
+    void WriteY4mFrame(const CapturedFrame& frame) {
+        const int w = mWidth, h = mHeight;
+        mPlanes.resize((size_t)w * h * 3 / 2);
+        unsigned char* yPlane = mPlanes.data();
+        unsigned char* uPlane = yPlane + (size_t)w * h;
+        unsigned char* vPlane = uPlane + (size_t)w * h / 4;
+
+        for (int y = 0; y < h; y++) {
+            const unsigned char* row = &frame.rgba[(size_t)(h - 1 - y) * w * 4];
+            for (int x = 0; x < w; x++) {
+                const unsigned char* p = row + x * 4;
+                yPlane[(size_t)y * w + x] = (unsigned char)((77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8);
+            }
+        }
+        for (int y = 0; y < h / 2; y++) {
+            const unsigned char* top = &frame.rgba[(size_t)(h - 1 - 2 * y) * w * 4];
+            const unsigned char* bottom = &frame.rgba[(size_t)(h - 2 - 2 * y) * w * 4];
+            for (int x = 0; x < w / 2; x++) {
+                int r = top[x * 8] + top[x * 8 + 4] + bottom[x * 8] + bottom[x * 8 + 4];
+                int g = top[x * 8 + 1] + top[x * 8 + 5] + bottom[x * 8 + 1] + bottom[x * 8 + 5];
+                int b = top[x * 8 + 2] + top[x * 8 + 6] + bottom[x * 8 + 2] + bottom[x * 8 + 6];
+                uPlane[(size_t)y * (w / 2) + x] = (unsigned char)((((-43 * r - 85 * g + 128 * b) >> 2) + (128 << 8)) >> 8);
+                vPlane[(size_t)y * (w / 2) + x] = (unsigned char)((((128 * r - 107 * g - 21 * b) >> 2) + (128 << 8)) >> 8);
+            }
+        }
+
+        fputs("FRAME\n", mStream);
+        fwrite(mPlanes.data(), 1, mPlanes.size(), mStream);
+    }
+
+    void FlipRows(std::vector<unsigned char>& rgba) {
+        size_t stride = (size_t)mWidth * 4;
+        mRow.resize(stride);
+        for (int y = 0; y < mHeight / 2; y++) {
+            unsigned char* a = &rgba[(size_t)y * stride];
+            unsigned char* b = &rgba[(size_t)(mHeight - 1 - y) * stride];
+            memcpy(mRow.data(), a, stride);
+            memcpy(a, b, stride);
+            memcpy(b, mRow.data(), stride);
+        }
+    }
+
+    bool mRunning = false;
+    CaptureFormat mFormat = CaptureFormat::Png;
+    std::string mPath;
+    int mWidth = 0;
+    int mHeight = 0;
+    FILE* mStream = nullptr;
+
+    // Main thread only
+    GLuint mBuffers[kCaptureRingSize] = {};
+    GLsync mFences[kCaptureRingSize] = {};
+    uint64_t mSlotFrame[kCaptureRingSize] = {};
+    int mHead = 0;
+    int mInFlight = 0;
+    uint64_t mFrameIndex = 0;
+    double mCaptureMs = 0.0;
+
+    // Writer thread only
+    std::vector<unsigned char> mPlanes;
+    std::vector<unsigned char> mRow;
+
+    // Shared, guarded by mQueueMutex
+    std::thread mWriter;
+    std::mutex mQueueMutex;
+    std::condition_variable mQueueWake;
+    std::deque<CapturedFrame> mQueue;
+    std::vector<std::vector<unsigned char>> mSpare;
+    uint64_t mFramesWritten = 0;
+    uint64_t mFramesDropped = 0;
+    bool mWriterQuit = false;
+};
@@ -0,0 +1,276 @@
+// Frame profiler with a hitch flight recorder
+// Keeps a rolling ring of the last few seconds of zone timings and counters.
+// When a frame goes over the hitch threshold the ring is handed to a writer
+// thread and dumped as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+//
+// Zones and counters are recorded from the main thread only. Zone and counter
+// names must be string literals (or otherwise outlive the profiler).
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+constexpr int kMaxProfileZones = 32;
+constexpr int kMaxProfileCounters = 16;
+
+struct ProfileZoneSample {
+    const char* name;
+    double startUs;
+    double durationUs;
+    int depth;
+};
+
+struct ProfileCounter {
+    const char* name;
+    double value;
+};
+
+struct FrameRecord {
+    uint64_t frame;
+    double startUs;
+    double durationUs;
+    int zoneCount;
+    int counterCount;
+    ProfileZoneSample zones[kMaxProfileZones];
+    ProfileCounter counters[kMaxProfileCounters];
+};
+
+class FrameProfiler {
+public:
+    static FrameProfiler& Get() {
+        static FrameProfiler sInstance;
+        return sInstance;
+    }
+
+    ~FrameProfiler() {
+        {
+            std::lock_guard<std::mutex> lock(mWriterMutex);
+            mWriterQuit = true;
+        }
+        mWriterWake.notify_one();
+        if (mWriter.joinable()) mWriter.join();
+    }
+
+    // Keep historySeconds worth of frames at expectedFps; frames longer than
+    // hitchThresholdMs trigger a dump into traceDirectory
+    void Configure(float historySeconds, int expectedFps, double hitchThresholdMs, const std::string& traceDirectory) {
+        size_t capacity = (size_t)(historySeconds * expectedFps);
+        mRing.assign(capacity > 0 ? capacity : 1, FrameRecord());
+        mRingHead = 0;
+        mRingCount = 0;
+        mHitchThresholdUs = hitchThresholdMs * 1000.0;
+        mTraceDirectory = traceDirectory;
+    }
+
+    void BeginFrame() {
+        mCurrent.frame = mFrameIndex;
+        mCurrent.startUs = NowUs();
+        mCurrent.durationUs = 0.0;
+        mCurrent.zoneCount = 0;
+        mCurrent.counterCount = 0;
+        mZoneDepth = 0;
+    }
+
+    void EndFrame() {
+        double now = NowUs();
+        mCurrent.durationUs = now - mCurrent.startUs;
+
+#ifdef __GLIBC__
+        // mallinfo2 locks and walks every malloc arena, so it is only read
+        // every so often and the frames in between repeat the last value
+        if (mFrameIndex % kHeapSampleFrames == 0) mHeapBytes = (double)mallinfo2().uordblks;
+        SetCounter("heap_bytes", mHeapBytes);
+#endif
+
+        mRing[mRingHead] = mCurrent;
+        mRingHead = (mRingHead + 1) % mRing.size();
+        if (mRingCount < mRing.size()) mRingCount++;
+
+        // The first frames include loading and are always slow
+        if (mFrameIndex >= kWarmupFrames && mCurrent.durationUs > mHitchThresholdUs) {
+            mDumpPending = true;
+        }
+
+        // Hitches during the cooldown are picked up by the next dump, which
+        // still has them in the ring
+        if (mDumpPending && now - mLastDumpUs >= kDumpCooldownUs) {
+            QueueDump(mCurrent.frame);
+            mDumpPending = false;
+            mLastDumpUs = now;
+        }
+
+        mFrameIndex++;
+    }
+
+    void BeginZone(const char* name) {
+        // Zones past the per-frame limit are still tracked for nesting, just not recorded
+        int index = -1;
+        if (mCurrent.zoneCount < kMaxProfileZones) {
+            index = mCurrent.zoneCount++;
+            ProfileZoneSample& zone = mCurrent.zones[index];
+            zone.name = name;
+            zone.startUs = NowUs() - mCurrent.startUs;
+            zone.durationUs = 0.0;
+            zone.depth = mZoneDepth;
+        }
+        if (mZoneDepth < kMaxProfileZones) mOpenZones[mZoneDepth] = index;
+        mZoneDepth++;
+    }
+
+    void EndZone() {
+        if (mZoneDepth == 0) return;
+        mZoneDepth--;
+        if (mZoneDepth >= kMaxProfileZones || mOpenZones[mZoneDepth] < 0) return;
+
+        ProfileZoneSample& zone = mCurrent.zones[mOpenZones[mZoneDepth]];
+        zone.durationUs = NowUs() - mCurrent.startUs - zone.startUs;
+    }
+
+    void SetCounter(const char* name, double value) {
+        for (int i = 0; i < mCurrent.counterCount; i++) {
+            if (strcmp(mCurrent.counters[i].name, name) == 0) {
+                mCurrent.counters[i].value = value;
+                return;
+            }
+        }
+        if (mCurrent.counterCount >= kMaxProfileCounters) return;
+        mCurrent.counters[mCurrent.counterCount++] = { name, value };
+    }
+
+    int GetDumpCount() const { return mDumpCount; }
+
+private:
+    static constexpr uint64_t kWarmupFrames = 10;
+    static constexpr double kDumpCooldownUs = 1000000.0;
+    static constexpr uint64_t kHeapSampleFrames = 60;
+
+    FrameProfiler() {
+        Configure(5.0f, 60, 50.0, ".");
+    }
+
+    double NowUs() const {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - mEpoch).count();
+    }
+
+    // Copy the ring oldest-first and hand it to the writer thread
+    void QueueDump(uint64_t hitchFrame) {
+        std::vector<FrameRecord> frames;
+        frames.reserve(mRingCount);
+        size_t oldest = (mRingHead + mRing.size() - mRingCount) % mRing.size();
+        for (size_t i = 0; i < mRingCount; i++) {
+            frames.push_back(mRing[(oldest + i) % mRing.size()]);
+        }
+
+        std::string path = mTraceDirectory + "/hitch_" + std::to_string(hitchFrame) + ".json";
+        {
+            std::lock_guard<std::mutex> lock(mWriterMutex);
+            mDumps.push_back({ path, std::move(frames) });
+            if (!mWriter.joinable()) mWriter = std::thread(&FrameProfiler::WriterLoop, this);
+        }
+        mWriterWake.notify_one();
+        mDumpCount++;
+    }
+
+    struct PendingDump {
+        std::string path;
+        std::vector<FrameRecord> frames;
+    };
+
+    void WriterLoop() {
+        std::unique_lock<std::mutex> lock(mWriterMutex);
+        while (true) {
+            mWriterWake.wait(lock, [this]() { return mWriterQuit || !mDumps.empty(); });
+            if (mDumps.empty()) return;
+
+            PendingDump dump = std::move(mDumps.front());
+            mDumps.pop_front();
+            lock.unlock();
+            WriteTrace(dump);
+            lock.lock();
+        }
+    }
+
+    static void WriteTrace(const PendingDump& dump) {
+        FILE* file = fopen(dump.path.c_str(), "w");
+        if (file == nullptr) {
+            fprintf(stderr, "Hitch recorder: can't write %s\n", dump.path.c_str());
+            return;
+        }
+
+        fprintf(file, "{\"traceEvents\":[\n");
+        bool first = true;
+        for (const FrameRecord& record : dump.frames) {
+            fprintf(file, "%s{\"name\":\"Frame %llu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f}",
+                first ? "" : ",\n", (unsigned long long)record.frame, record.startUs, record.durationUs);
+            first = false;
+
+            for (int i = 0; i < record.zoneCount; i++) {
+                const ProfileZoneSample& zone = record.zones[i];
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f}",
+                    zone.name, record.startUs + zone.startUs, zone.durationUs);
+            }
+            for (int i = 0; i < record.counterCount; i++) {
+                const ProfileCounter& counter = record.counters[i];
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.1f,\"args\":{\"value\":%.3f}}",
+                    counter.name, record.startUs, counter.value);
+            }
+        }
+        fprintf(file, "\n]}\n");
+        fclose(file);
+
+        fprintf(stderr, "Hitch recorder: wrote %zu frames to %s\n", dump.frames.size(), dump.path.c_str());
+    }
+
+    std::chrono::steady_clock::time_point mEpoch = std::chrono::steady_clock::now();
+    std::vector<FrameRecord> mRing;
+    size_t mRingHead = 0;
+    size_t mRingCount = 0;
+    FrameRecord mCurrent = {};
+    int mOpenZones[kMaxProfileZones] = {};
+    int mZoneDepth = 0;
+    uint64_t mFrameIndex = 0;
+    double mHeapBytes = 0.0; // Last mallinfo2 sample
+    double mHitchThresholdUs = 50000.0;
+    double mLastDumpUs = -kDumpCooldownUs;
+    bool mDumpPending = false;
+    int mDumpCount = 0;
+    std::string mTraceDirectory;
+
+    std::thread mWriter;
+    std::mutex mWriterMutex;
+    std::condition_variable mWriterWake;
+    std::deque<PendingDump> mDumps;
+    bool mWriterQuit = false;
+};
+
+// Scoped zone: ProfileZone zone("Physics");
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) { FrameProfiler::Get().BeginZone(name); }
+    ~ProfileZone() { FrameProfiler::Get().EndZone(); }
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+// Configure the profiler from LEVELFORGE_HITCH_MS / LEVELFORGE_TRACE_DIR,
+// falling back to the given threshold and the working directory
+inline void ConfigureHitchRecorder(int expectedFps, double defaultThresholdMs) {
+    const char* thresholdEnv = getenv("LEVELFORGE_HITCH_MS");
+    const char* directoryEnv = getenv("LEVELFORGE_TRACE_DIR");
+    double thresholdMs = thresholdEnv != nullptr ? atof(thresholdEnv) : defaultThresholdMs;
+    FrameProfiler::Get().Configure(5.0f, expectedFps, thresholdMs, directoryEnv != nullptr ? directoryEnv : ".");
+}
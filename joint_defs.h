@@ -0,0 +1,130 @@
+// Joint definitions
+// Engine-neutral description of the `joints:` section of a screen. A joint
+// connects two bodies by index into the screen's body list, or one body to
+// the world. Chain generators expand into link bodies plus the joints between
+// them, so a 10k-link rope is one entry in YAML rather than 10k.
+//
+// Joints are emitted in solver-friendly order: chains run from their anchor
+// outward, so consecutive constraints share a body and stay close in memory.
+// Each joint also gets a unique priority that grows toward the anchor. Solvers
+// that honour it (Jolt solves higher priorities later) satisfy the
+// load-bearing joints most accurately. The solve order then also stops
+// depending on creation order.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+enum class JointType {
+    Revolute,  // Hinge around axis, or a ball joint if axis is zero (3D)
+    Distance,  // Keeps the anchors between minLimit and maxLimit apart
+    Prismatic, // Slides along axis within [minLimit, maxLimit]
+    Weld,      // Rigid connection
+};
+
+constexpr int kWorldBody = -1;
+
+struct JointPoint {
+    float x, y, z;
+};
+
+struct JointDef {
+    JointType type;
+    int bodyA;          // Index into the screen's bodies, or kWorldBody
+    int bodyB;
+    JointPoint anchorA; // World space; only Distance joints use two anchors
+    JointPoint anchorB;
+    JointPoint axis;    // Hinge or slide axis; unused for Distance and Weld
+    float minLimit;     // Angle (rad) or distance; min > max means unlimited
+    float maxLimit;
+    uint32_t priority;  // Higher is solved later, i.e. more accurately
+};
+
+// `- type: chain` entry: links strung from start to end
+struct ChainDef {
+    JointPoint start;
+    JointPoint end;
+    int links;
+    float linkRadius;
+    float slack;        // Extra length as a fraction of the start-end distance
+    JointType jointType; // Revolute or Distance between links
+    bool anchorStart;   // Pin the first link to the world
+    bool anchorEnd;     // Pin the last link to the world
+    int solverSteps;    // Velocity step override for the chain's island, 0 for default
+};
+
+struct ChainLayout {
+    std::vector<JointPoint> linkPositions;
+    std::vector<JointDef> joints; // Body indices are link indices
+    float linkLength;
+};
+
+// Lay out a chain's links and joints. Slack sags the links downward (-y) in
+// a shallow arc so the chain starts close to rest instead of snapping taut.
+inline ChainLayout LayoutChain(const ChainDef& chain) {
+    ChainLayout layout;
+    int links = std::max(1, chain.links);
+
+    float dx = chain.end.x - chain.start.x;
+    float dy = chain.end.y - chain.start.y;
+    float dz = chain.end.z - chain.start.z;
+    float span = std::sqrt(dx * dx + dy * dy + dz * dz);
+    layout.linkLength = span * (1.0f + std::max(0.0f, chain.slack)) / links;
+    float sag = 0.5f * span * std::sqrt(std::max(0.0f, chain.slack));
+
+    layout.linkPositions.reserve(links);
+    for (int i = 0; i < links; i++) {
+        float t = (i + 0.5f) / links;
+        float drop = sag * 4.0f * t * (1.0f - t);
+        layout.linkPositions.push_back({ chain.start.x + dx * t, chain.start.y + dy * t - drop, chain.start.z + dz * t });
+    }
+
+    // Joint i sits between link i-1 and link i (the world for the ends)
+    auto pointAt = [&](int joint) {
+        float t = (float)joint / links;
+        float drop = sag * 4.0f * t * (1.0f - t);
+        return JointPoint{ chain.start.x + dx * t, chain.start.y + dy * t - drop, chain.start.z + dz * t };
+    };
+
+    // Rank by distance to the nearest anchor; a free chain ranks from its start
+    auto rank = [&](int joint) {
+        int fromStart = joint;
+        int fromEnd = links - joint;
+        if (chain.anchorStart && chain.anchorEnd) return std::min(fromStart, fromEnd);
+        if (chain.anchorEnd) return fromEnd;
+        return fromStart;
+    };
+
+    int firstJoint = chain.anchorStart ? 0 : 1;
+    int lastJoint = chain.anchorEnd ? links : links - 1;
+    layout.joints.reserve(std::max(0, lastJoint - firstJoint + 1));
+    for (int joint = firstJoint; joint <= lastJoint; joint++) {
+        JointDef def;
+        def.type = chain.jointType;
+        def.bodyA = joint == 0 ? kWorldBody : joint - 1;
+        def.bodyB = joint == links ? kWorldBody : joint;
+        def.axis = { 0.0f, 0.0f, 0.0f }; // Links swing freely
+        if (chain.jointType == JointType::Distance) {
+            // Rope: link centers may close up but never stretch past one link
+            def.anchorA = def.bodyA == kWorldBody ? pointAt(joint) : layout.linkPositions[def.bodyA];
+            def.anchorB = def.bodyB == kWorldBody ? pointAt(joint) : layout.linkPositions[def.bodyB];
+            def.minLimit = 0.0f;
+            def.maxLimit = def.bodyA == kWorldBody || def.bodyB == kWorldBody ? 0.5f * layout.linkLength : layout.linkLength;
+        } else {
+            def.anchorA = pointAt(joint);
+            def.anchorB = def.anchorA;
+            def.minLimit = 1.0f; // Unlimited
+            def.maxLimit = -1.0f;
+        }
+        // Unique: rank first, then side of the chain
+        def.priority = (uint32_t)((links - rank(joint)) * 2 + (joint * 2 < links ? 1 : 0));
+        layout.joints.push_back(def);
+    }
+
+    // Anchored at the end only: emit from the end so the anchor still comes first
+    if (chain.anchorEnd && !chain.anchorStart) std::reverse(layout.joints.begin(), layout.joints.end());
+    return layout;
+}
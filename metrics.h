@@ -0,0 +1,350 @@
+// Metrics export
+// Counters, gauges and histograms for soak tests, flushed every few seconds
+// to a local file or a statsd-style UDP endpoint. Updates are relaxed atomics,
+// safe and cheap from any thread. Look a metric up once and keep the reference:
+//
+//   static MetricCounter& hits = MetricsRegistry::Get().GetCounter("targets_hit");
+//   hits.Add();
+//
+// Configured from the environment, so any build can be pointed at a sink:
+//   LEVELFORGE_METRICS=file:<path>        append statsd lines to a file
+//   LEVELFORGE_METRICS=udp:<host>:<port>  send statsd datagrams
+//   LEVELFORGE_METRICS_INTERVAL=<sec>     flush period (default 10)
+//
+// Counters are sent as the change since the last flush. Histograms are
+// windowed: each flush reports count, p50, p90, p99 and max of the values
+// recorded since the previous one, then starts over. metrics_receiver.cpp is a
+// local endpoint for tests (./build.sh tools).
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class MetricCounter {
+public:
+    void Add(int64_t amount = 1) { mValue.fetch_add(amount, std::memory_order_relaxed); }
+    int64_t Load() const { return mValue.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> mValue{ 0 };
+};
+
+class MetricGauge {
+public:
+    void Set(double value) { mValue.store(value, std::memory_order_relaxed); }
+    double Load() const { return mValue.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> mValue{ 0.0 };
+};
+
+// Log-scale buckets, eight per doubling from 1/1024 up to about 4 million.
+// Percentiles report a bucket's upper edge, so they read at most 9% high
+// (2^(1/8)) whatever the unit.
+class MetricHistogram {
+public:
+    static constexpr int kBucketsPerDoubling = 8;
+    static constexpr int kBucketCount = 256;
+
+    void Record(double value) {
+        mBuckets[BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+        double max = mMax.load(std::memory_order_relaxed);
+        while (value > max && !mMax.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+    }
+
+    struct Summary {
+        uint64_t count;
+        double p50, p90, p99, max;
+    };
+
+    // Summarize and reset. Values recorded while this runs land in either
+    // window, never lost.
+    Summary TakeWindow() {
+        uint64_t counts[kBucketCount];
+        uint64_t total = 0;
+        for (int i = 0; i < kBucketCount; i++) {
+            counts[i] = mBuckets[i].exchange(0, std::memory_order_relaxed);
+            total += counts[i];
+        }
+        Summary summary = { total, 0.0, 0.0, 0.0, mMax.exchange(0.0, std::memory_order_relaxed) };
+        if (total == 0) return summary;
+
+        // Bucket edges can overshoot the largest value actually seen
+        summary.p50 = std::min(Percentile(counts, total, 0.50), summary.max);
+        summary.p90 = std::min(Percentile(counts, total, 0.90), summary.max);
+        summary.p99 = std::min(Percentile(counts, total, 0.99), summary.max);
+        return summary;
+    }
+
+private:
+    static int BucketFor(double value) {
+        if (!(value > kMinValue)) return 0;
+        int bucket = 1 + (int)(std::log2(value / kMinValue) * kBucketsPerDoubling);
+        return std::min(bucket, kBucketCount - 1);
+    }
+
+    // Upper edge of the bucket holding the given fraction of values
+    static double Percentile(const uint64_t* counts, uint64_t total, double fraction) {
+        uint64_t rank = (uint64_t)std::ceil(total * fraction);
+        uint64_t seen = 0;
+        for (int i = 0; i < kBucketCount; i++) {
+            seen += counts[i];
+            if (seen >= rank) return kMinValue * std::exp2((double)i / kBucketsPerDoubling);
+        }
+        return kMinValue * std::exp2((double)(kBucketCount - 1) / kBucketsPerDoubling);
+    }
+
+    static constexpr double kMinValue = 1.0 / 1024.0;
+
+    std::atomic<uint64_t> mBuckets[kBucketCount] = {};
+    std::atomic<double> mMax{ 0.0 };
+};
+
+class MetricsRegistry {
+public:
+    static MetricsRegistry& Get() {
+        static MetricsRegistry sInstance;
+        return sInstance;
+    }
+
+    ~MetricsRegistry() { Stop(); }
+
+    // Registration takes a lock; the returned references stay valid forever.
+    // Names must be string literals (or otherwise outlive the registry).
+    MetricCounter& GetCounter(const char* name) { return Find(mCounters, name); }
+    MetricGauge& GetGauge(const char* name) { return Find(mGauges, name); }
+    MetricHistogram& GetHistogram(const char* name) { return Find(mHistograms, name); }
+
+    // Gauge read by the flusher just before each flush, for values too costly
+    // to update every frame. sample runs on the flusher thread.
+    void AddSampledGauge(const char* name, double (*sample)()) {
+        std::lock_guard<std::mutex> lock(mRegistryMutex);
+        mSampledGauges.push_back({ name, sample });
+    }
+
+    // Start flushing to "file:<path>" or "udp:<host>:<port>"
+    bool Start(const char* sink, double intervalSeconds) {
+        if (mFlusher.joinable()) return false;
+        if (strncmp(sink, "file:", 5) == 0) {
+            mFile = fopen(sink + 5, "a");
+            if (mFile == nullptr) return false;
+        } else if (strncmp(sink, "udp:", 4) == 0) {
+            if (!OpenSocket(sink + 4)) return false;
+        } else {
+            return false;
+        }
+
+        mInterval = std::chrono::duration<double>(std::max(0.1, intervalSeconds));
+        mQuit = false;
+        mFlusher = std::thread(&MetricsRegistry::FlushLoop, this);
+        return true;
+    }
+
+    // Final flush, then stop the flusher
+    void Stop() {
+        if (!mFlusher.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mFlushMutex);
+            mQuit = true;
+        }
+        mFlushWake.notify_one();
+        mFlusher.join();
+        if (mFile != nullptr) fclose(mFile);
+        if (mSocket >= 0) close(mSocket);
+        mFile = nullptr;
+        mSocket = -1;
+    }
+
+    bool IsRunning() const { return mFlusher.joinable(); }
+
+private:
+    template <typename T>
+    struct Named {
+        const char* name;
+        T metric;
+        int64_t lastSent = 0; // Counters only
+    };
+
+    struct SampledGauge {
+        const char* name;
+        double (*sample)();
+    };
+
+    MetricsRegistry() = default;
+
+    template <typename T>
+    T& Find(std::deque<Named<T>>& list, const char* name) {
+        std::lock_guard<std::mutex> lock(mRegistryMutex);
+        for (Named<T>& entry : list) {
+            if (strcmp(entry.name, name) == 0) return entry.metric;
+        }
+        list.emplace_back();
+        list.back().name = name;
+        return list.back().metric;
+    }
+
+    bool OpenSocket(const char* hostAndPort) {
+        std::string host = hostAndPort;
+        size_t colon = host.rfind(':');
+        if (colon == std::string::npos) return false;
+        std::string port = host.substr(colon + 1);
+        host.resize(colon);
+
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0 || result == nullptr) return false;
+
+        mSocket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+        bool connected = mSocket >= 0 && connect(mSocket, result->ai_addr, result->ai_addrlen) == 0;
+        freeaddrinfo(result);
+        if (!connected && mSocket >= 0) {
+            close(mSocket);
+            mSocket = -1;
+        }
+        return connected;
+    }
+
+    void FlushLoop() {
+        std::unique_lock<std::mutex> lock(mFlushMutex);
+        while (true) {
+            bool quit = mFlushWake.wait_for(lock, mInterval, [this]() { return mQuit; });
+            lock.unlock();
+            Flush();
+            lock.lock();
+            if (quit) return;
+        }
+    }
+
+    void Flush() {
+        mBuffer.clear();
+        char line[256];
+        {
+            std::lock_guard<std::mutex> lock(mRegistryMutex);
+            for (Named<MetricCounter>& counter : mCounters) {
+                int64_t value = counter.metric.Load();
+                AppendLine(line, snprintf(line, sizeof(line), "levelforge.%s:%lld|c\n", counter.name,
+                    (long long)(value - counter.lastSent)));
+                counter.lastSent = value;
+            }
+            for (Named<MetricGauge>& gauge : mGauges) {
+                AppendLine(line, snprintf(line, sizeof(line), "levelforge.%s:%g|g\n", gauge.name, gauge.metric.Load()));
+            }
+            for (const SampledGauge& gauge : mSampledGauges) {
+                AppendLine(line, snprintf(line, sizeof(line), "levelforge.%s:%g|g\n", gauge.name, gauge.sample()));
+            }
+            for (Named<MetricHistogram>& histogram : mHistograms) {
+                MetricHistogram::Summary summary = histogram.metric.TakeWindow();
+                AppendLine(line, snprintf(line, sizeof(line), "levelforge.%s.count:%llu|c\n", histogram.name,
+                    (unsigned long long)summary.count));
+                if (summary.count == 0) continue;
+                const char* suffixes[] = { "p50", "p90", "p99", "max" };
+                const double values[] = { summary.p50, summary.p90, summary.p99, summary.max };
+                for (int i = 0; i < 4; i++) {
+                    AppendLine(line, snprintf(line, sizeof(line), "levelforge.%s.%s:%g|g\n", histogram.name, suffixes[i], values[i]));
+                }
+            }
+        }
+
+        if (mFile != nullptr) {
+            fprintf(mFile, "# %lld\n", (long long)time(nullptr));
+            fwrite(mBuffer.data(), 1, mBuffer.size(), mFile);
+            fflush(mFile);
+        }
+        if (mSocket >= 0) SendDatagrams();
+    }
+
+    // Lines too long for the buffer are dropped rather than sent cut short
+    void AppendLine(const char* line, int length) {
+        if (length > 0 && length < 256) mBuffer.append(line, length);
+    }
+
+    // Whole lines per datagram, kept under a typical MTU
+    void SendDatagrams() {
+        const size_t kMaxDatagram = 1400;
+        size_t start = 0;
+        while (start < mBuffer.size()) {
+            size_t end = start;
+            while (end < mBuffer.size()) {
+                size_t next = mBuffer.find('\n', end);
+                next = next == std::string::npos ? mBuffer.size() : next + 1;
+                if (next - start > kMaxDatagram && end > start) break;
+                end = next;
+            }
+            send(mSocket, mBuffer.data() + start, end - start, 0);
+            start = end;
+        }
+    }
+
+    std::mutex mRegistryMutex;
+    std::deque<Named<MetricCounter>> mCounters;
+    std::deque<Named<MetricGauge>> mGauges;
+    std::deque<Named<MetricHistogram>> mHistograms;
+    std::deque<SampledGauge> mSampledGauges;
+
+    // Flusher thread only, after Start
+    FILE* mFile = nullptr;
+    int mSocket = -1;
+    std::string mBuffer;
+
+    std::thread mFlusher;
+    std::mutex mFlushMutex;
+    std::condition_variable mFlushWake;
+    std::chrono::duration<double> mInterval{ 10.0 };
+    bool mQuit = false;
+};
+
+// Start flushing if LEVELFORGE_METRICS is set. Returns whether it started.
+inline bool StartMetricsFromEnvironment() {
+    const char* sink = getenv("LEVELFORGE_METRICS");
+    if (sink == nullptr || *sink == '\0') return false;
+    const char* intervalEnv = getenv("LEVELFORGE_METRICS_INTERVAL");
+    double interval = intervalEnv != nullptr ? atof(intervalEnv) : 10.0;
+#ifdef __GLIBC__
+    // mallinfo2 walks every malloc arena, so read it once per flush, not per frame
+    static bool sHeapSampled = false;
+    if (!sHeapSampled) MetricsRegistry::Get().AddSampledGauge("heap_bytes", []() { return (double)mallinfo2().uordblks; });
+    sHeapSampled = true;
+#endif
+    if (!MetricsRegistry::Get().Start(sink, interval)) {
+        fprintf(stderr, "Metrics: can't open %s\n", sink);
+        return false;
+    }
+    fprintf(stderr, "Metrics: flushing to %s every %.1f s\n", sink, interval);
+    return true;
+}
+
+// Metrics for the lifetime of main: starts from the environment and does the
+// final flush on whichever path main returns by, headless runs included
+struct ScopedMetrics {
+    ScopedMetrics() { StartMetricsFromEnvironment(); }
+    ~ScopedMetrics() { MetricsRegistry::Get().Stop(); }
+};
+
+// Per-frame metrics every game records. Heap in use is sampled at each flush
+// (see StartMetricsFromEnvironment).
+inline void RecordFrameMetrics(float frameSeconds) {
+    static MetricHistogram& frameMs = MetricsRegistry::Get().GetHistogram("frame_ms");
+    frameMs.Record(frameSeconds * 1000.0);
+}
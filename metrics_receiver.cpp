@@ -0,0 +1,119 @@
+// Local metrics receiver
+// Listens for the statsd datagrams sent by metrics.h and prints them, so soak
+// test runs can be checked without a real statsd/Graphite setup. Counters are
+// summed and gauges keep their latest value; a summary is printed on exit.
+//
+//   ./metrics_receiver [--port 8125] [--out metrics.log] [--packets n]
+//   LEVELFORGE_METRICS=udp:127.0.0.1:8125 ./demo_3d
+//
+// --packets exits after that many datagrams, which makes it usable from test
+// scripts. Ctrl+C also exits with a summary.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+static volatile sig_atomic_t gQuit = 0;
+
+static void OnSignal(int) {
+    gQuit = 1;
+}
+
+struct MetricTotal {
+    char type;     // 'c' or 'g'
+    double value;  // Sum for counters, latest for gauges
+    long updates;
+};
+
+int main(int argc, char** argv) {
+    int port = 8125;
+    const char* outPath = nullptr;
+    long maxPackets = 0;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--port") == 0 && hasValue) port = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && hasValue) outPath = argv[++i];
+        else if (strcmp(argv[i], "--packets") == 0 && hasValue) maxPackets = atol(argv[++i]);
+        else {
+            fprintf(stderr, "Usage: %s [--port 8125] [--out file] [--packets n]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((uint16_t)port);
+    if (sock < 0 || bind(sock, (sockaddr*)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "Can't listen on 127.0.0.1:%d: %s\n", port, strerror(errno));
+        return 1;
+    }
+
+    FILE* out = outPath != nullptr ? fopen(outPath, "a") : nullptr;
+    if (outPath != nullptr && out == nullptr) {
+        fprintf(stderr, "Can't open %s\n", outPath);
+        return 1;
+    }
+
+    // No SA_RESTART, so recv returns on Ctrl+C
+    struct sigaction action = {};
+    action.sa_handler = OnSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    printf("Listening for metrics on 127.0.0.1:%d\n", port);
+    std::map<std::string, MetricTotal> totals;
+    long packets = 0;
+    char buffer[65536];
+    while (!gQuit && (maxPackets == 0 || packets < maxPackets)) {
+        ssize_t received = recv(sock, buffer, sizeof(buffer) - 1, 0);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        buffer[received] = '\0';
+        packets++;
+
+        fputs(buffer, stdout);
+        fflush(stdout);
+        if (out != nullptr) {
+            fputs(buffer, out);
+            fflush(out);
+        }
+
+        // name:value|type per line
+        char* saveLine = nullptr;
+        for (char* line = strtok_r(buffer, "\n", &saveLine); line != nullptr; line = strtok_r(nullptr, "\n", &saveLine)) {
+            char* colon = strrchr(line, ':');
+            char* bar = colon != nullptr ? strchr(colon, '|') : nullptr;
+            if (bar == nullptr) continue;
+            *colon = '\0';
+            MetricTotal& total = totals[line];
+            double value = atof(colon + 1);
+            total.type = bar[1];
+            total.value = total.type == 'c' ? total.value + value : value;
+            total.updates++;
+        }
+    }
+
+    printf("\n%ld packets, %zu metrics\n", packets, totals.size());
+    for (const auto& entry : totals) {
+        const MetricTotal& total = entry.second;
+        printf("%-48s %-7s %14.3f  (%ld updates)\n", entry.first.c_str(), total.type == 'c' ? "total" : "last",
+            total.value, total.updates);
+    }
+
+    if (out != nullptr) fclose(out);
+    close(sock);
+    return 0;
+}
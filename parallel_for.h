@@ -0,0 +1,131 @@
+// Parallel helpers for level construction
+// Splits index ranges across worker threads and times load stages
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Run fn(begin, end) over [0, count) split into contiguous chunks, one per
+// worker. Jobs smaller than minPerThread items per worker run inline, since
+// spawning threads would cost more than it saves.
+template <typename Fn>
+void ParallelFor(int count, int minPerThread, Fn&& fn) {
+    int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    int numThreads = std::min(maxThreads, count / std::max(1, minPerThread));
+    if (numThreads <= 1) {
+        if (count > 0) fn(0, count);
+        return;
+    }
+
+    int chunk = (count + numThreads - 1) / numThreads;
+    std::vector<std::thread> workers;
+    for (int begin = chunk; begin < count; begin += chunk) {
+        int end = std::min(count, begin + chunk);
+        workers.emplace_back([&fn, begin, end]() { fn(begin, end); });
+    }
+
+    // The calling thread takes the first chunk
+    fn(0, std::min(count, chunk));
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Persistent worker threads fed from one queue, for work handed off many
+// times a frame (Box2D's solver tasks) where starting a thread per job would
+// cost more than the job. Each job gets the index of the worker running it,
+// which is unique among the jobs running at once.
+class WorkerPool {
+public:
+    // Jobs submitted together, waited on together
+    struct Group {
+        std::atomic<int> pending{ 0 };
+    };
+
+    explicit WorkerPool(int workerCount) {
+        for (int i = 0; i < std::max(1, workerCount); i++) {
+            mThreads.emplace_back(&WorkerPool::WorkerLoop, this, i);
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQuit = true;
+        }
+        mWake.notify_all();
+        for (std::thread& thread : mThreads) thread.join();
+    }
+
+    int GetWorkerCount() const { return (int)mThreads.size(); }
+
+    void Submit(Group& group, std::function<void(int worker)> job) {
+        group.pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mJobs.push_back({ &group, std::move(job) });
+        }
+        mWake.notify_one();
+    }
+
+    // Block until every job in the group has run
+    void Wait(Group& group) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait(lock, [&group]() { return group.pending.load(std::memory_order_acquire) == 0; });
+    }
+
+private:
+    struct Job {
+        Group* group;
+        std::function<void(int worker)> run;
+    };
+
+    void WorkerLoop(int worker) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true) {
+            mWake.wait(lock, [this]() { return mQuit || !mJobs.empty(); });
+            if (mJobs.empty()) return;
+
+            Job job = std::move(mJobs.front());
+            mJobs.pop_front();
+            lock.unlock();
+            job.run(worker);
+            lock.lock();
+            // Under the lock, so a waiter can't miss the wakeup
+            job.group->pending.fetch_sub(1, std::memory_order_release);
+            mDone.notify_all();
+        }
+    }
+
+    std::vector<std::thread> mThreads;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    std::deque<Job> mJobs;
+    bool mQuit = false;
+};
+
+// Wall-clock timer for load stages; Lap() returns ms since the previous lap
+class StageTimer {
+public:
+    StageTimer() : mLast(std::chrono::steady_clock::now()) {}
+
+    double Lap() {
+        auto now = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - mLast).count();
+        mLast = now;
+        return ms;
+    }
+
+private:
+    std::chrono::steady_clock::time_point mLast;
+};
@@ -0,0 +1,263 @@
+// Render graph
+// A frame is described as passes that each draw into one target, reading any
+// number of targets written by earlier passes. Before running them the graph:
+//   - culls passes whose output never reaches the screen
+//   - works out each transient target's lifetime, from its first write to
+//     its last read
+//   - aliases targets whose lifetimes don't overlap onto one render texture
+//     when they have the same size
+// Render textures are pooled across frames. New ones are only created when
+// nothing free in the pool has the right size, so a steady frame allocates
+// nothing. Textures no longer requested (after a resize, or a resolution
+// change) are released at the end of the frame's compile.
+//
+// Targets are sized as a fraction of the screen. Memory is counted as RGBA8
+// plus the depth buffer raylib attaches to every render texture. Each frame's
+// stats give the memory used next to what one texture per target would take.
+//
+//   graph.BeginFrame(GetScreenWidth(), GetScreenHeight());
+//   int scene = graph.AddTarget("scene", 1.0f);
+//   graph.AddPass("world", {}, scene, true, BLACK, [&]() { ... });
+//   graph.AddPass("composite", { scene }, kRenderBackbuffer, false, BLANK, [&]() {
+//       DrawRenderTarget(graph.GetTexture(scene), screenRect, WHITE);
+//   });
+//   BeginDrawing();
+//   graph.Execute();
+//   EndDrawing();
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include "raylib.h"
+
+constexpr int kRenderBackbuffer = -1; // Output of passes that draw to the screen
+
+struct RenderGraphStats {
+    int passes = 0;
+    int culledPasses = 0;
+    int targets = 0;          // Transient targets used by live passes
+    int textures = 0;         // Render textures they were aliased onto
+    size_t bytes = 0;         // Memory of those textures
+    size_t unaliasedBytes = 0; // One texture per target
+    int texturesCreated = 0;  // This frame, because the pool had nothing free
+};
+
+class RenderGraph {
+public:
+    ~RenderGraph() { Release(); }
+
+    // Unload pooled textures; call before closing the window
+    void Release() {
+        for (Physical& physical : mPool) UnloadRenderTexture(physical.texture);
+        mPool.clear();
+    }
+
+    void BeginFrame(int screenWidth, int screenHeight) {
+        mScreenWidth = screenWidth;
+        mScreenHeight = screenHeight;
+        mTargets.clear();
+        mPasses.clear();
+    }
+
+    // Transient target, scale times the screen size
+    int AddTarget(const char* name, float scale) {
+        Target target;
+        target.name = name;
+        target.width = std::max(1, (int)(mScreenWidth * scale));
+        target.height = std::max(1, (int)(mScreenHeight * scale));
+        mTargets.push_back(target);
+        return (int)mTargets.size() - 1;
+    }
+
+    // Passes run in the order they are added; inputs must be written by an
+    // earlier pass. Without clear, the output starts with undefined contents
+    // unless an earlier pass wrote it this frame.
+    void AddPass(const char* name, std::initializer_list<int> inputs, int output, bool clear, Color clearColor,
+                 std::function<void()> execute) {
+        Pass pass;
+        pass.name = name;
+        pass.inputs.assign(inputs.begin(), inputs.end());
+        pass.output = output;
+        pass.clear = clear;
+        pass.clearColor = clearColor;
+        pass.execute = std::move(execute);
+        mPasses.push_back(std::move(pass));
+    }
+
+    // Compile and run the live passes. Call between BeginDrawing and EndDrawing.
+    void Execute() {
+        Compile();
+        for (const Pass& pass : mPasses) {
+            if (!pass.live) continue;
+            if (pass.output == kRenderBackbuffer) {
+                if (pass.clear) ClearBackground(pass.clearColor);
+                pass.execute();
+                continue;
+            }
+            BeginTextureMode(mPool[mTargets[pass.output].physical].texture);
+            if (pass.clear) ClearBackground(pass.clearColor);
+            pass.execute();
+            EndTextureMode();
+        }
+    }
+
+    // Texture behind a target, valid while its passes run. A target no live
+    // pass has written has none and gets an invalid texture (id 0), which
+    // raylib skips when drawing.
+    const Texture2D& GetTexture(int target) const {
+        static const Texture2D sInvalid = {};
+        if (target < 0 || target >= (int)mTargets.size() || mTargets[target].physical < 0) {
+            TraceLog(LOG_WARNING, "RenderGraph: target %d has no texture, it isn't written by a live pass", target);
+            return sInvalid;
+        }
+        return mPool[mTargets[target].physical].texture.texture;
+    }
+
+    const RenderGraphStats& GetStats() const { return mStats; }
+    size_t GetPeakBytes() const { return mPeakBytes; }
+    size_t GetPeakUnaliasedBytes() const { return mPeakUnaliasedBytes; }
+
+private:
+    struct Target {
+        const char* name;
+        int width, height;
+        int firstPass = -1; // Live passes only
+        int lastPass = -1;
+        int physical = -1;
+    };
+
+    struct Pass {
+        const char* name;
+        std::vector<int> inputs;
+        int output;
+        bool clear;
+        Color clearColor;
+        std::function<void()> execute;
+        bool live = false;
+    };
+
+    struct Physical {
+        RenderTexture2D texture;
+        bool inUse = false;
+        bool requested = false; // By this frame
+    };
+
+    static size_t TextureBytes(int width, int height) {
+        return (size_t)width * height * 8; // RGBA8 color + 32-bit depth
+    }
+
+    void Compile() {
+        mStats = RenderGraphStats();
+        mStats.passes = (int)mPasses.size();
+
+        // Walk back from the screen, keeping passes whose output is needed
+        std::vector<bool> needed(mTargets.size(), false);
+        for (int p = (int)mPasses.size() - 1; p >= 0; p--) {
+            Pass& pass = mPasses[p];
+            pass.live = pass.output == kRenderBackbuffer || needed[pass.output];
+            if (!pass.live) {
+                mStats.culledPasses++;
+                continue;
+            }
+            for (int input : pass.inputs) needed[input] = true;
+        }
+
+        // Lifetimes over the live passes
+        for (int p = 0; p < (int)mPasses.size(); p++) {
+            const Pass& pass = mPasses[p];
+            if (!pass.live) continue;
+            for (int input : pass.inputs) {
+                Target& target = mTargets[input];
+                if (target.firstPass < 0) TraceLog(LOG_WARNING, "RenderGraph: pass %s reads %s before any pass writes it", pass.name, target.name);
+                target.lastPass = p;
+            }
+            if (pass.output != kRenderBackbuffer) {
+                Target& target = mTargets[pass.output];
+                if (target.firstPass < 0) target.firstPass = p;
+                target.lastPass = std::max(target.lastPass, p);
+            }
+        }
+
+        // Hand out textures in pass order. A pass's output is acquired before
+        // the targets it last reads are released, so they never alias.
+        for (Physical& physical : mPool) {
+            physical.inUse = false;
+            physical.requested = false;
+        }
+        for (int p = 0; p < (int)mPasses.size(); p++) {
+            if (!mPasses[p].live) continue;
+            for (Target& target : mTargets) {
+                if (target.firstPass == p) {
+                    target.physical = Acquire(target.width, target.height);
+                    mStats.targets++;
+                    mStats.unaliasedBytes += TextureBytes(target.width, target.height);
+                }
+            }
+            for (Target& target : mTargets) {
+                if (target.lastPass == p && target.physical >= 0) mPool[target.physical].inUse = false;
+            }
+        }
+
+        // Drop textures this frame didn't ask for; indices of the rest shift
+        std::vector<int> remap(mPool.size(), -1);
+        size_t kept = 0;
+        for (size_t i = 0; i < mPool.size(); i++) {
+            if (!mPool[i].requested) {
+                UnloadRenderTexture(mPool[i].texture);
+                continue;
+            }
+            remap[i] = (int)kept;
+            mPool[kept++] = mPool[i];
+        }
+        mPool.resize(kept);
+        for (Target& target : mTargets) {
+            if (target.physical >= 0) target.physical = remap[target.physical];
+        }
+
+        mStats.textures = (int)mPool.size();
+        for (const Physical& physical : mPool) {
+            mStats.bytes += TextureBytes(physical.texture.texture.width, physical.texture.texture.height);
+        }
+        mPeakBytes = std::max(mPeakBytes, mStats.bytes);
+        mPeakUnaliasedBytes = std::max(mPeakUnaliasedBytes, mStats.unaliasedBytes);
+    }
+
+    int Acquire(int width, int height) {
+        for (size_t i = 0; i < mPool.size(); i++) {
+            Physical& physical = mPool[i];
+            if (physical.inUse || physical.texture.texture.width != width || physical.texture.texture.height != height) continue;
+            physical.inUse = true;
+            physical.requested = true;
+            return (int)i;
+        }
+        Physical physical;
+        physical.texture = LoadRenderTexture(width, height);
+        SetTextureFilter(physical.texture.texture, TEXTURE_FILTER_BILINEAR); // For passes that scale
+        physical.inUse = true;
+        physical.requested = true;
+        mPool.push_back(physical);
+        mStats.texturesCreated++;
+        return (int)mPool.size() - 1;
+    }
+
+    int mScreenWidth = 0;
+    int mScreenHeight = 0;
+    std::vector<Target> mTargets;
+    std::vector<Pass> mPasses;
+    std::vector<Physical> mPool;
+    RenderGraphStats mStats;
+    size_t mPeakBytes = 0;
+    size_t mPeakUnaliasedBytes = 0;
+};
+
+// Draw a render target's texture into dest. Render textures are stored
+// bottom-up, so the source rectangle is flipped.
+inline void DrawRenderTarget(const Texture2D& texture, Rectangle dest, Color tint) {
+    Rectangle source = { 0.0f, 0.0f, (float)texture.width, -(float)texture.height };
+    DrawTexturePro(texture, source, dest, { 0.0f, 0.0f }, 0.0f, tint);
+}
@@ -0,0 +1,160 @@
+// UI layout
+// Resolves screen elements (text and panels) from positions given at a
+// reference resolution into window rectangles, the way screen YAML describes
+// them: `position`, `font_size`, `size` and `anchor: left|center|right`.
+//
+//   - Positions scale with the window per axis, so elements keep their place
+//     relative to the edges and the middle when the window is resized.
+//   - Font sizes and pixel sizes scale uniformly, with the smaller axis.
+//     Sizes can instead be a fraction of the window (an overlay covering it
+//     is size 1 x 1).
+//   - The anchor picks which part of the element sits on its position.
+//
+// Results are cached on the elements. Update() lays everything out again only
+// when the window size or DPI scale changed, and otherwise just the elements
+// whose text changed, so text is measured once per change instead of every
+// frame. Drawing reads the cached rectangles.
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "raylib.h"
+
+enum class UiAnchor { Left, Center, Right };
+
+enum class UiElementType { Text, Panel };
+
+struct UiElement {
+    UiElementType type = UiElementType::Text;
+    std::string text;
+    Vector2 position = { 0.0f, 0.0f }; // Reference pixels, top edge
+    Vector2 size = { 0.0f, 0.0f };     // Panels only: reference pixels, or a fraction of the window
+    bool relativeSize = false;
+    int fontSize = 20;                 // Text only, reference pixels
+    UiAnchor anchor = UiAnchor::Left;
+    Color color = WHITE;
+    bool visible = true;
+
+    // Layout results
+    Rectangle bounds = { 0.0f, 0.0f, 0.0f, 0.0f };
+    int scaledFontSize = 0;
+    bool dirty = true;
+};
+
+class UiLayout {
+public:
+    UiLayout(float referenceWidth, float referenceHeight) :
+        mReferenceWidth(referenceWidth), mReferenceHeight(referenceHeight) {}
+
+    int AddText(const std::string& text, Vector2 position, int fontSize, UiAnchor anchor, Color color) {
+        UiElement element;
+        element.text = text;
+        element.position = position;
+        element.fontSize = fontSize;
+        element.anchor = anchor;
+        element.color = color;
+        mElements.push_back(element);
+        return (int)mElements.size() - 1;
+    }
+
+    int AddPanel(Vector2 position, Vector2 size, bool relativeSize, UiAnchor anchor, Color color) {
+        UiElement element;
+        element.type = UiElementType::Panel;
+        element.position = position;
+        element.size = size;
+        element.relativeSize = relativeSize;
+        element.anchor = anchor;
+        element.color = color;
+        mElements.push_back(element);
+        return (int)mElements.size() - 1;
+    }
+
+    // Only marks the element for layout when the text actually differs
+    void SetText(int index, const char* text) {
+        UiElement& element = mElements[index];
+        if (element.text == text) return;
+        element.text = text;
+        element.dirty = true;
+    }
+
+    // Visibility doesn't affect layout
+    void SetVisible(int index, bool visible) { mElements[index].visible = visible; }
+
+    const UiElement& Get(int index) const { return mElements[index]; }
+    const std::vector<UiElement>& GetElements() const { return mElements; }
+
+    // Elements laid out by the last Update, for profiling
+    int GetLayoutCount() const { return mLayoutCount; }
+
+    // Lay out whatever is stale for this window size and DPI scale. raylib
+    // draws in logical window units and applies the monitor's scale itself,
+    // so pass 1 for those; the scale is only for layouts in framebuffer pixels
+    // (GetRenderWidth()).
+    void Update(int screenWidth, int screenHeight, float dpiScale) {
+        bool resized = screenWidth != mScreenWidth || screenHeight != mScreenHeight || dpiScale != mDpiScale;
+        if (resized) {
+            mScreenWidth = screenWidth;
+            mScreenHeight = screenHeight;
+            mDpiScale = dpiScale;
+            mScaleX = screenWidth / mReferenceWidth;
+            mScaleY = screenHeight / mReferenceHeight;
+            mScale = std::min(mScaleX, mScaleY) * dpiScale;
+        }
+
+        mLayoutCount = 0;
+        for (UiElement& element : mElements) {
+            if (!resized && !element.dirty) continue;
+            LayOut(element);
+            element.dirty = false;
+            mLayoutCount++;
+        }
+    }
+
+private:
+    void LayOut(UiElement& element) const {
+        float width, height;
+        if (element.type == UiElementType::Text) {
+            element.scaledFontSize = std::max(1, (int)(element.fontSize * mScale + 0.5f));
+            width = (float)MeasureText(element.text.c_str(), element.scaledFontSize);
+            height = (float)element.scaledFontSize;
+        } else if (element.relativeSize) {
+            width = element.size.x * mScreenWidth;
+            height = element.size.y * mScreenHeight;
+        } else {
+            width = element.size.x * mScale;
+            height = element.size.y * mScale;
+        }
+
+        float x = element.position.x * mScaleX;
+        if (element.anchor == UiAnchor::Center) x -= width / 2.0f;
+        else if (element.anchor == UiAnchor::Right) x -= width;
+        element.bounds = { x, element.position.y * mScaleY, width, height };
+    }
+
+    float mReferenceWidth;
+    float mReferenceHeight;
+    std::vector<UiElement> mElements;
+
+    int mScreenWidth = 0;
+    int mScreenHeight = 0;
+    float mDpiScale = 0.0f;
+    float mScaleX = 1.0f;
+    float mScaleY = 1.0f;
+    float mScale = 1.0f; // Sizes and fonts
+    int mLayoutCount = 0;
+};
+
+// Draw visible elements in the order they were added
+inline void DrawUiLayout(const UiLayout& layout) {
+    for (const UiElement& element : layout.GetElements()) {
+        if (!element.visible) continue;
+        if (element.type == UiElementType::Panel) {
+            DrawRectangleRec(element.bounds, element.color);
+        } else {
+            DrawText(element.text.c_str(), (int)element.bounds.x, (int)element.bounds.y, element.scaledFontSize, element.color);
+        }
+    }
+}